@@ -0,0 +1,227 @@
+/*
+ * append.h
+ * Incremental regridding of time steps missing from an existing output in FastRegrid.
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#ifndef FASTREGRID_APPEND_H
+#define FASTREGRID_APPEND_H
+
+#include "config.h"
+#include "types.h"
+#include "grid_store.h"
+#include "io.h"
+#include "grid.h"
+#include "weights.h"
+#include "interpolation.h"
+#include "thread_pool.h"
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <memory>
+#include <optional>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace fastregrid
+{
+
+    // Brings an existing regridded.txt in config.output_path up to date with
+    // its source: target rows whose time step does not appear in the output
+    // yet (e.g. a newly added year) are regridded and appended; nothing else
+    // is recomputed. Weights are cached in config.weights_file next to the
+    // output and reused while the source and target grids and the search
+    // parameters are unchanged. Without an existing output, append() performs
+    // a full run.
+    //
+    // New rows are appended in target file order, so the output matches a full
+    // run when new time steps come last in the target file. Mapping files are
+    // not written.
+    class IncrementalRegridder
+    {
+    public:
+        IncrementalRegridder(const std::string &source_file, const std::string &target_file, const RegridConfig &config)
+            : source_file_(source_file), target_file_(target_file), config_(config)
+        {
+            if (source_file_.empty() || target_file_.empty())
+            {
+                throw std::runtime_error("Source or target file path is empty");
+            }
+        }
+
+        // Appends the missing rows and returns how many were written.
+        size_t append() const
+        {
+            InputReader source_reader(source_file_, config_);
+            InputReader target_reader(target_file_, config_);
+            std::vector<std::string> headers = source_reader.read_headers();
+            validate_headers(headers, target_reader.read_headers(), config_);
+
+            OutputWriter writer(config_);
+            const std::string output_file = writer.path("regridded.txt");
+            bool existing = false;
+            std::unordered_set<int> done = written_time_steps(output_file, headers.size(), existing);
+
+            // Step 1: Target rows at time steps missing from the output
+            const LargeBufferPolicy policy = buffer_policy(config_);
+            size_t stride = 0;
+            GridStore target_points = target_reader.read_locations(stride);
+            std::vector<size_t> row_locations;
+            Grid target_grid(target_points, policy, &row_locations);
+
+            GridStore new_points(0, policy);
+            std::vector<size_t> new_locations;
+            std::unordered_set<int> needed;
+            for (size_t row = 0; row < target_points.size(); ++row)
+            {
+                if (done.count(target_points.time_step(row)) == 0)
+                {
+                    new_points.push_back(target_points.longitude(row), target_points.latitude(row),
+                                         target_points.time_step(row));
+                    new_locations.push_back(row_locations[row]);
+                    needed.insert(target_points.time_step(row));
+                }
+            }
+            target_points = GridStore();
+            if (config_.verbose)
+            {
+                std::cout << "Output has " << done.size() << " time steps; " << needed.size()
+                          << " to append (" << new_points.size() << " target rows)" << std::endl;
+            }
+            if (new_points.empty())
+            {
+                return 0;
+            }
+
+            // Step 2: One pass over the source, keeping values only at the needed time steps
+            GridStore source_locations(0, policy);
+            GridStore source_rows(0, policy);
+            source_reader.scan([&](double lon, double lat, int time_step, const ValueType *values, size_t count)
+                               {
+                source_locations.push_back(lon, lat, time_step);
+                if (needed.count(time_step) != 0)
+                {
+                    if (source_rows.empty())
+                    {
+                        source_rows.set_stride(count);
+                    }
+                    source_rows.push_back(lon, lat, time_step, values);
+                } });
+            if (source_locations.empty())
+            {
+                throw std::runtime_error("Empty input file: " + source_file_);
+            }
+            auto source_grid = std::make_shared<const Grid>(source_locations, policy);
+            source_locations = GridStore();
+            if (source_rows.empty())
+            {
+                source_rows.set_stride(stride);
+            }
+            Field source_field(source_rows, source_grid, policy, &pool_for(config_));
+            source_rows = GridStore();
+
+            // Step 3: Cached weights, rebuilt when the grids or parameters changed
+            const std::string weights_file = writer.path(config_.weights_file);
+            std::optional<RegridWeights> cached = RegridWeights::load(weights_file, source_grid->fingerprint(),
+                                                                      target_grid.fingerprint(), config_);
+            const bool rebuilt = !cached;
+            if (rebuilt)
+            {
+                if (config_.verbose)
+                {
+                    std::cout << "Building weights (no matching cache in " << weights_file << ")" << std::endl;
+                }
+                cached = RegridWeights::build(source_grid->longitudes().data(), source_grid->latitudes().data(),
+                                              source_grid->size(), target_grid.longitudes().data(),
+                                              target_grid.latitudes().data(), target_grid.size(), config_);
+                cached->save(weights_file, source_grid->fingerprint(), target_grid.fingerprint(), config_);
+            }
+
+            GridStore interpolated_points =
+                Interpolator(source_field, config_).interpolate_rows(new_points, new_locations, *cached);
+
+            // Step 4: Append
+            std::ofstream file(output_file, std::ios::app);
+            if (!file.is_open())
+            {
+                throw std::runtime_error("Cannot open output file: " + output_file);
+            }
+            if (!existing)
+            {
+                writer.write_headers(file, headers);
+            }
+            writer.write_rows(file, interpolated_points);
+            file.close();
+            if (!file)
+            {
+                throw std::runtime_error("Cannot write outputs to: " + output_file);
+            }
+            if (!existing || rebuilt)
+            {
+                writer.write_gridlist(source_grid->longitudes(), source_grid->latitudes(), "source_gridlist.txt");
+                writer.write_gridlist(target_grid.longitudes(), target_grid.latitudes(), "target_gridlist.txt");
+            }
+            if (config_.verbose)
+            {
+                std::cout << "Appended " << interpolated_points.size() << " rows to: " << output_file << std::endl;
+            }
+            return interpolated_points.size();
+        }
+
+    private:
+        // Time steps of the rows in an existing output; sets existing if the file is there.
+        std::unordered_set<int> written_time_steps(const std::string &filename, size_t columns, bool &existing) const
+        {
+            std::unordered_set<int> time_steps;
+            std::ifstream file(filename, std::ios::binary);
+            existing = file.is_open();
+            if (!existing)
+            {
+                return time_steps;
+            }
+
+            std::string line;
+            std::getline(file, line);
+            std::istringstream header(line);
+            size_t header_columns = 0;
+            for (std::string name; header >> name;)
+            {
+                ++header_columns;
+            }
+            if (header_columns != columns)
+            {
+                throw std::runtime_error("Existing output has different columns than the source: " + filename);
+            }
+            while (std::getline(file, line))
+            {
+                if (file.eof())
+                {
+                    // An interrupted writer can leave a partial last row
+                    throw std::runtime_error("Existing output ends with an incomplete row: " + filename);
+                }
+                std::istringstream iss(line);
+                double lon, lat;
+                int time_step;
+                if (iss >> lon >> lat >> time_step)
+                {
+                    time_steps.insert(time_step);
+                }
+            }
+            return time_steps;
+        }
+
+        std::string source_file_;
+        std::string target_file_;
+        const RegridConfig &config_;
+    };
+
+} // namespace fastregrid
+
+#endif // FASTREGRID_APPEND_H
@@ -0,0 +1,83 @@
+/*
+ * arena.h
+ * Per-run monotonic arenas for short-lived allocations in FastRegrid.
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#ifndef FASTREGRID_ARENA_H
+#define FASTREGRID_ARENA_H
+
+#include <memory_resource>
+#include <memory>
+#include <vector>
+#include <stdexcept>
+#include <cstddef>
+
+namespace fastregrid
+{
+
+    // Monotonic arena for objects that live until the end of a regrid run.
+    // Deallocation is a no-op; all memory is returned in one go by release()
+    // or when the arena is destroyed. Not thread-safe: use one per thread.
+    class Arena
+    {
+    public:
+        explicit Arena(size_t initial_bytes = 1 << 20)
+            : resource_(initial_bytes, std::pmr::new_delete_resource())
+        {
+        }
+
+        Arena(const Arena &) = delete;
+        Arena &operator=(const Arena &) = delete;
+
+        std::pmr::memory_resource *resource() { return &resource_; }
+
+        // Frees everything allocated from this arena.
+        void release() { resource_.release(); }
+
+    private:
+        std::pmr::monotonic_buffer_resource resource_;
+    };
+
+    // One arena per worker thread, so parallel stages never share an allocator.
+    class ArenaSet
+    {
+    public:
+        explicit ArenaSet(size_t num_arenas, size_t initial_bytes = 1 << 20)
+        {
+            if (num_arenas == 0)
+            {
+                throw std::invalid_argument("ArenaSet needs at least one arena");
+            }
+            arenas_.reserve(num_arenas);
+            for (size_t i = 0; i < num_arenas; ++i)
+            {
+                arenas_.push_back(std::make_unique<Arena>(initial_bytes));
+            }
+        }
+
+        size_t size() const { return arenas_.size(); }
+
+        // Arena owned by the given worker (0 <= worker < size()).
+        Arena &local(size_t worker) { return *arenas_.at(worker); }
+
+        void release()
+        {
+            for (auto &arena : arenas_)
+            {
+                arena->release();
+            }
+        }
+
+    private:
+        std::vector<std::unique_ptr<Arena>> arenas_;
+    };
+
+} // namespace fastregrid
+
+#endif // FASTREGRID_ARENA_H
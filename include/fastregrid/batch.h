@@ -0,0 +1,305 @@
+/*
+ * batch.h
+ * Runs manifests of regridding jobs, sharing weights between jobs on the same grids in FastRegrid.
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#ifndef FASTREGRID_BATCH_H
+#define FASTREGRID_BATCH_H
+
+#include "config.h"
+#include "types.h"
+#include "grid_store.h"
+#include "io.h"
+#include "grid.h"
+#include "weights.h"
+#include "interpolation.h"
+#include "thread_pool.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+#include <cstdint>
+
+namespace fastregrid
+{
+
+    // One manifest entry: regrid source_file onto the rows of target_file and
+    // write the outputs of a normal run to output_path.
+    struct BatchJob
+    {
+        std::string source_file;
+        std::string target_file;
+        std::string output_path;
+    };
+
+    // Reads a manifest with one job per line: source, target and output
+    // directory separated by whitespace. Blank lines and lines starting with
+    // '#' are skipped.
+    inline std::vector<BatchJob> read_manifest(const std::string &filename)
+    {
+        std::ifstream file(filename);
+        if (!file.is_open())
+        {
+            throw std::runtime_error("Cannot open manifest: " + filename);
+        }
+        std::vector<BatchJob> jobs;
+        std::string line;
+        for (size_t line_number = 1; std::getline(file, line); ++line_number)
+        {
+            std::istringstream fields(line);
+            BatchJob job;
+            std::string extra;
+            if (!(fields >> job.source_file) || job.source_file[0] == '#')
+            {
+                continue;
+            }
+            if (!(fields >> job.target_file >> job.output_path) || (fields >> extra))
+            {
+                throw std::runtime_error("Invalid manifest line " + std::to_string(line_number) + " in " + filename +
+                                         ": expected <source> <target> <output_dir>");
+            }
+            jobs.push_back(std::move(job));
+        }
+        return jobs;
+    }
+
+    // Runs a list of jobs with one weight computation per distinct pair of
+    // source and target grids. Grids are identified by fingerprint (confirmed
+    // by exact comparison), so jobs over different files on the same grids,
+    // e.g. one file per variable, share their search.
+    //
+    // At most max_io jobs read or write files at once, each on its own runner
+    // thread; the weight sets are built concurrently, and the jobs' search and
+    // interpolation run, on the shared thread pool.
+    class BatchRunner
+    {
+    public:
+        BatchRunner(std::vector<BatchJob> jobs, const RegridConfig &config, size_t max_io = 2)
+            : jobs_(std::move(jobs)), config_(config), max_io_(std::max<size_t>(1, max_io))
+        {
+            if (config_.tile_size > 0.0)
+            {
+                throw std::invalid_argument("Batch runs do not support tiled processing");
+            }
+        }
+
+        // Runs every job and returns the number that failed; each failure is
+        // reported on std::cerr and does not stop the other jobs.
+        size_t run()
+        {
+            errors_.assign(jobs_.size(), std::string());
+            grids_.clear();
+            grid_ids_.clear();
+            ThreadPool runners(max_io_);
+
+            // Step 1: Fingerprint the grid of every distinct file (locations only;
+            // values are parsed once, by the jobs)
+            std::vector<std::string> files;
+            std::map<std::string, size_t> file_index;
+            for (const auto &job : jobs_)
+            {
+                for (const std::string *file : {&job.source_file, &job.target_file})
+                {
+                    if (file_index.emplace(*file, files.size()).second)
+                    {
+                        files.push_back(*file);
+                    }
+                }
+            }
+            if (config_.verbose)
+            {
+                std::cout << "Fingerprinting " << files.size() << " files for " << jobs_.size() << " jobs..." << std::endl;
+            }
+            std::vector<size_t> file_grid(files.size(), npos);
+            std::vector<std::string> file_errors(files.size());
+            runners.parallel_for(0, files.size(), 1, [&](size_t begin, size_t end)
+                                 {
+                for (size_t f = begin; f < end; ++f)
+                {
+                    try
+                    {
+                        auto grid = Grid::load(files[f], config_);
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        file_grid[f] = intern(std::move(grid));
+                    }
+                    catch (const std::exception &e)
+                    {
+                        file_errors[f] = e.what();
+                    }
+                } });
+
+            // Step 2: One weight set per distinct (source grid, target grid) pair
+            std::map<std::pair<size_t, size_t>, size_t> pair_index;
+            std::vector<std::pair<size_t, size_t>> pairs;
+            std::vector<size_t> job_weights(jobs_.size(), npos);
+            for (size_t j = 0; j < jobs_.size(); ++j)
+            {
+                const size_t source = file_index.at(jobs_[j].source_file);
+                const size_t target = file_index.at(jobs_[j].target_file);
+                if (file_grid[source] == npos || file_grid[target] == npos)
+                {
+                    errors_[j] = file_grid[source] == npos ? file_errors[source] : file_errors[target];
+                    continue;
+                }
+                auto key = std::make_pair(file_grid[source], file_grid[target]);
+                auto it = pair_index.emplace(key, pairs.size()).first;
+                if (it->second == pairs.size())
+                {
+                    pairs.push_back(key);
+                }
+                job_weights[j] = it->second;
+            }
+            if (config_.verbose)
+            {
+                std::cout << "Building " << pairs.size() << " weight sets (" << grids_.size() << " distinct grids)..."
+                          << std::endl;
+            }
+            weights_.clear();
+            weights_.resize(pairs.size());
+            pool_for(config_).parallel_for(0, pairs.size(), 1, [&](size_t begin, size_t end)
+                                           {
+                for (size_t p = begin; p < end; ++p)
+                {
+                    const Grid &source_grid = *grids_[pairs[p].first];
+                    const Grid &target_grid = *grids_[pairs[p].second];
+                    weights_[p] = RegridWeights::build(source_grid.longitudes().data(), source_grid.latitudes().data(),
+                                                       source_grid.size(), target_grid.longitudes().data(),
+                                                       target_grid.latitudes().data(), target_grid.size(), config_);
+                } });
+
+            // Step 3: Apply the shared weights to every job
+            runners.parallel_for(0, jobs_.size(), 1, [&](size_t begin, size_t end)
+                                 {
+                for (size_t j = begin; j < end; ++j)
+                {
+                    if (job_weights[j] == npos)
+                    {
+                        continue;
+                    }
+                    try
+                    {
+                        run_job(jobs_[j], grids_[pairs[job_weights[j]].first], weights_[job_weights[j]]);
+                    }
+                    catch (const std::exception &e)
+                    {
+                        errors_[j] = e.what();
+                    }
+                } });
+
+            size_t failed = 0;
+            for (size_t j = 0; j < jobs_.size(); ++j)
+            {
+                if (!errors_[j].empty())
+                {
+                    std::cerr << "Job " << j + 1 << " (" << jobs_[j].source_file << " -> " << jobs_[j].output_path
+                              << ") failed: " << errors_[j] << std::endl;
+                    ++failed;
+                }
+            }
+            if (config_.verbose)
+            {
+                std::cout << "Batch completed: " << jobs_.size() - failed << " of " << jobs_.size() << " jobs succeeded."
+                          << std::endl;
+            }
+            return failed;
+        }
+
+        const std::vector<BatchJob> &jobs() const { return jobs_; }
+
+        // Error message of each job after run(); empty for jobs that succeeded.
+        const std::vector<std::string> &errors() const { return errors_; }
+
+        // Number of weight sets computed by the last run().
+        size_t weight_sets() const { return weights_.size(); }
+
+    private:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        // Id of the grid equal to grid, adding it if new. Caller holds mutex_.
+        size_t intern(std::shared_ptr<const Grid> grid)
+        {
+            const uint64_t fingerprint = grid->fingerprint();
+            auto range = grid_ids_.equal_range(fingerprint);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                const Grid &known = *grids_[it->second];
+                if (known.longitudes() == grid->longitudes() && known.latitudes() == grid->latitudes())
+                {
+                    return it->second;
+                }
+            }
+            grid_ids_.emplace(fingerprint, grids_.size());
+            grids_.push_back(std::move(grid));
+            return grids_.size() - 1;
+        }
+
+        // Regrids one job with precomputed weights, writing the usual outputs.
+        void run_job(const BatchJob &job, const std::shared_ptr<const Grid> &source_grid,
+                     const RegridWeights &weights) const
+        {
+            RegridConfig job_config = config_;
+            job_config.output_path = job.output_path;
+            job_config.write_mappings = false;
+
+            InputReader source_reader(job.source_file, job_config);
+            InputReader target_reader(job.target_file, job_config);
+            std::vector<std::string> headers = source_reader.read_headers();
+            validate_headers(headers, target_reader.read_headers(), job_config);
+
+            // The source was fingerprinted to source_grid, so its rows map onto it
+            Field source_field = job_config.memory_budget != 0 ? Field::load(job.source_file, job_config)
+                                                               : Field::load(job.source_file, source_grid, job_config);
+            size_t stride = 0;
+            GridStore target_points = target_reader.read_locations(stride);
+            std::vector<size_t> row_locations;
+            const LargeBufferPolicy policy = buffer_policy(job_config);
+            Grid target_grid(target_points, policy, &row_locations);
+            if (target_grid.size() != weights.target_size() || source_grid->size() != weights.source_size())
+            {
+                throw std::runtime_error("Grids of " + job.source_file + " changed during the batch run");
+            }
+
+            GridStore interpolated_points =
+                Interpolator(source_field, job_config).interpolate_rows(target_points, row_locations, weights);
+            if (interpolated_points.empty())
+            {
+                throw std::runtime_error(job_config.interp_method == NEAREST_NEIGHBOR ? "No points interpolated in NN mode"
+                                                                                      : "No points interpolated in IDW mode");
+            }
+
+            OutputWriter writer(job_config);
+            writer.write_gridlist(source_grid->longitudes(), source_grid->latitudes(), "source_gridlist.txt");
+            writer.write_gridlist(target_grid.longitudes(), target_grid.latitudes(), "target_gridlist.txt");
+            writer.write_regridded_data(interpolated_points, "regridded.txt", headers);
+            if (config_.verbose)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                std::cout << "Regridded " << job.source_file << " -> " << writer.path("regridded.txt") << std::endl;
+            }
+        }
+
+        std::vector<BatchJob> jobs_;
+        RegridConfig config_;
+        size_t max_io_;
+        std::vector<std::string> errors_;
+        std::vector<std::shared_ptr<const Grid>> grids_;
+        std::unordered_multimap<uint64_t, size_t> grid_ids_;
+        std::vector<RegridWeights> weights_;
+        mutable std::mutex mutex_;
+    };
+
+} // namespace fastregrid
+
+#endif // FASTREGRID_BATCH_H
@@ -0,0 +1,174 @@
+/*
+ * checkpoint.h
+ * Chunk-granular checkpoints of streaming regrid runs in FastRegrid.
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#ifndef FASTREGRID_CHECKPOINT_H
+#define FASTREGRID_CHECKPOINT_H
+
+#include "config.h"
+#include "types.h"
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <optional>
+#include <stdexcept>
+#include <cstdio>
+#include <cstdint>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef NOGDI
+#define NOGDI // wingdi.h defines ERROR, a FastRegridLogger level
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace fastregrid
+{
+
+    // Size and modification time of an input file, to detect changed inputs.
+    struct FileStamp
+    {
+        int64_t size = -1;
+        int64_t modified = -1;
+
+        static FileStamp of(const std::string &filename)
+        {
+            FileStamp stamp;
+            struct stat info;
+            if (stat(filename.c_str(), &info) == 0)
+            {
+                stamp.size = static_cast<int64_t>(info.st_size);
+                stamp.modified = static_cast<int64_t>(info.st_mtime);
+            }
+            return stamp;
+        }
+
+        bool operator==(const FileStamp &other) const { return size == other.size && modified == other.modified; }
+    };
+
+    // Progress of a streaming regrid after its last completed chunk: target rows
+    // consumed, output rows written and the byte size of every output file at
+    // that point. Outputs are truncated back to these sizes on resume, so rows
+    // written after the checkpoint are discarded rather than duplicated.
+    struct Checkpoint
+    {
+        FileStamp source;
+        FileStamp target;
+        std::string settings; // settings_of() the run's config
+        uint64_t next_row = 0;
+        uint64_t rows_written = 0;
+        uint64_t data_bytes = 0;
+        uint64_t nn_bytes = 0;
+        uint64_t idw_bytes = 0;
+
+        // Everything in config that changes the rows written or the chunk boundaries.
+        static std::string settings_of(const RegridConfig &config)
+        {
+            std::ostringstream out;
+            out.precision(17);
+            out << config.interp_method << ',' << config.distance_metric << ',' << config.data_layout << ','
+                << config.radius << ',' << config.power << ',' << config.max_points << ',' << config.min_points << ','
+                << config.adjust_longitude << ',' << config.precision << ',' << config.write_mappings << ','
+                << config.chunk_size << ',' << sizeof(ValueType);
+            return out.str();
+        }
+
+        // Writes the checkpoint to a temporary file, then renames it over filename,
+        // so a run killed mid-write leaves the previous checkpoint intact.
+        void save(const std::string &filename) const
+        {
+            const std::string temporary = filename + ".tmp";
+            {
+                std::ofstream file(temporary, std::ios::trunc);
+                if (!file.is_open())
+                {
+                    throw std::runtime_error("Cannot open checkpoint file: " + temporary);
+                }
+                file << "fastregrid-checkpoint 1\n"
+                     << "source " << source.size << ' ' << source.modified << '\n'
+                     << "target " << target.size << ' ' << target.modified << '\n'
+                     << "settings " << settings << '\n'
+                     << "next_row " << next_row << '\n'
+                     << "rows_written " << rows_written << '\n'
+                     << "bytes " << data_bytes << ' ' << nn_bytes << ' ' << idw_bytes << '\n';
+                file.close();
+                if (!file)
+                {
+                    throw std::runtime_error("Cannot write checkpoint file: " + temporary);
+                }
+            }
+#ifdef _WIN32
+            std::remove(filename.c_str());
+#endif
+            if (std::rename(temporary.c_str(), filename.c_str()) != 0)
+            {
+                throw std::runtime_error("Cannot replace checkpoint file: " + filename);
+            }
+        }
+
+        // Reads a checkpoint written by save(); nothing if it is missing or unreadable.
+        static std::optional<Checkpoint> load(const std::string &filename)
+        {
+            std::ifstream file(filename);
+            if (!file.is_open())
+            {
+                return std::nullopt;
+            }
+            Checkpoint checkpoint;
+            std::string magic, key;
+            int version = 0;
+            bool ok = static_cast<bool>(file >> magic >> version) && magic == "fastregrid-checkpoint" && version == 1;
+            ok = ok && (file >> key >> checkpoint.source.size >> checkpoint.source.modified) && key == "source";
+            ok = ok && (file >> key >> checkpoint.target.size >> checkpoint.target.modified) && key == "target";
+            ok = ok && (file >> key >> checkpoint.settings) && key == "settings";
+            ok = ok && (file >> key >> checkpoint.next_row) && key == "next_row";
+            ok = ok && (file >> key >> checkpoint.rows_written) && key == "rows_written";
+            ok = ok && (file >> key >> checkpoint.data_bytes >> checkpoint.nn_bytes >> checkpoint.idw_bytes) &&
+                 key == "bytes";
+            return ok ? std::optional<Checkpoint>(checkpoint) : std::nullopt;
+        }
+    };
+
+    // Size of a file in bytes, or -1 if it does not exist.
+    inline int64_t file_size(const std::string &filename)
+    {
+        return FileStamp::of(filename).size;
+    }
+
+    // Shrinks a file to size bytes.
+    inline void truncate_file(const std::string &filename, uint64_t size)
+    {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(filename.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        LARGE_INTEGER end;
+        end.QuadPart = static_cast<LONGLONG>(size);
+        const bool ok = file != INVALID_HANDLE_VALUE && SetFilePointerEx(file, end, nullptr, FILE_BEGIN) && SetEndOfFile(file);
+        if (file != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(file);
+        }
+#else
+        const bool ok = ::truncate(filename.c_str(), static_cast<off_t>(size)) == 0;
+#endif
+        if (!ok)
+        {
+            throw std::runtime_error("Cannot truncate output file: " + filename);
+        }
+    }
+
+} // namespace fastregrid
+
+#endif // FASTREGRID_CHECKPOINT_H
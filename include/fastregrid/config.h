@@ -15,10 +15,13 @@
 #include "types.h"
 #include <string>
 #include <stdexcept>
+#include <memory>
 
 namespace fastregrid
 {
 
+    class ThreadPool;
+
     // Configuration for regridding operations.
     struct RegridConfig
     {
@@ -35,8 +38,24 @@ namespace fastregrid
         bool write_mappings = false;                                   // Write mapping files
         std::string nn_mappings_file = "nn_mappings.txt";              // Nearest Neighbor mappings file
         std::string idw_mappings_file = "idw_mappings.txt";            // IDW mappings file
+        std::string weights_file = "weights.bin";                      // Cached weights file of incremental runs
         size_t chunk_size = 1000;                                      // Max lines to process at once
         std::string output_path = "./";                                // Output directory for all files (relative or absolute)
+        size_t num_threads = 1;                                        // Worker threads (0 = all hardware threads)
+        bool huge_pages = false;                                       // Back large buffers with transparent huge pages
+        NumaPlacement numa_placement = NUMA_LOCAL;                     // NUMA placement of large buffers
+        size_t memory_budget = 0;                                      // Bytes for in-memory source values (0 = unlimited)
+        std::string spill_path = "";                                   // Directory for spilled source values (empty = $TMPDIR or /tmp)
+        double tile_size = 0.0;                                        // Tile edge in degrees for tiled processing (0 = off)
+        size_t checkpoint_interval = 0;                                // Chunks between checkpoints of streaming runs (0 = off)
+        std::string checkpoint_file = "regrid.checkpoint";             // Checkpoint file name in output_path
+        size_t warning_examples = 5;                                   // Warnings of each kind logged in full before only being counted
+        bool write_stats = false;                                      // Write run statistics as JSON next to regridded.txt
+        std::string stats_file = "regrid_stats.json";                  // Run statistics file name in output_path
+        bool write_trace = false;                                      // Write a Chrome trace-event timeline of the run
+        std::string trace_file = "regrid_trace.json";                  // Trace file name in output_path
+        bool hardware_counters = false;                                // Count cycles, instructions, cache and branch misses per stage (Linux)
+        std::shared_ptr<ThreadPool> thread_pool;                       // Pool to run on (null = shared pool of num_threads)
     };
 
     // Builder class for constructing RegridConfig with validation.
@@ -159,6 +178,76 @@ namespace fastregrid
             return *this;
         }
 
+        RegridConfigBuilder &set_weights_file(const std::string &filename)
+        {
+            if (filename.empty())
+            {
+                throw std::invalid_argument("Weights filename cannot be empty");
+            }
+            config_.weights_file = filename;
+            return *this;
+        }
+
+        RegridConfigBuilder &set_checkpoint_interval(size_t chunks)
+        {
+            config_.checkpoint_interval = chunks;
+            return *this;
+        }
+
+        RegridConfigBuilder &set_checkpoint_file(const std::string &filename)
+        {
+            if (filename.empty())
+            {
+                throw std::invalid_argument("Checkpoint filename cannot be empty");
+            }
+            config_.checkpoint_file = filename;
+            return *this;
+        }
+
+        RegridConfigBuilder &set_warning_examples(size_t examples)
+        {
+            config_.warning_examples = examples;
+            return *this;
+        }
+
+        RegridConfigBuilder &set_write_stats(bool write)
+        {
+            config_.write_stats = write;
+            return *this;
+        }
+
+        RegridConfigBuilder &set_stats_file(const std::string &filename)
+        {
+            if (filename.empty())
+            {
+                throw std::invalid_argument("Stats filename cannot be empty");
+            }
+            config_.stats_file = filename;
+            return *this;
+        }
+
+        RegridConfigBuilder &set_write_trace(bool write)
+        {
+            config_.write_trace = write;
+            return *this;
+        }
+
+        RegridConfigBuilder &set_trace_file(const std::string &filename)
+        {
+            if (filename.empty())
+            {
+                throw std::invalid_argument("Trace filename cannot be empty");
+            }
+            config_.trace_file = filename;
+            return *this;
+        }
+
+        RegridConfigBuilder &set_hardware_counters(bool count)
+        {
+            config_.hardware_counters = count;
+            return *this;
+        }
+
         RegridConfigBuilder &set_chunk_size(size_t chunk_size)
         {
             if (chunk_size == 0)
@@ -175,6 +264,52 @@ namespace fastregrid
             return *this;
         }
 
+        RegridConfigBuilder &set_num_threads(size_t num_threads)
+        {
+            config_.num_threads = num_threads;
+            return *this;
+        }
+
+        RegridConfigBuilder &set_huge_pages(bool enable)
+        {
+            config_.huge_pages = enable;
+            return *this;
+        }
+
+        RegridConfigBuilder &set_numa_placement(NumaPlacement placement)
+        {
+            config_.numa_placement = placement;
+            return *this;
+        }
+
+        RegridConfigBuilder &set_memory_budget(size_t bytes)
+        {
+            config_.memory_budget = bytes;
+            return *this;
+        }
+
+        RegridConfigBuilder &set_spill_path(const std::string &path)
+        {
+            config_.spill_path = path;
+            return *this;
+        }
+
+        RegridConfigBuilder &set_tile_size(double degrees)
+        {
+            if (degrees < 0.0)
+            {
+                throw std::invalid_argument("Tile size must be non-negative");
+            }
+            config_.tile_size = degrees;
+            return *this;
+        }
+
+        RegridConfigBuilder &set_thread_pool(std::shared_ptr<ThreadPool> pool)
+        {
+            config_.thread_pool = std::move(pool);
+            return *this;
+        }
+
         RegridConfig build() const
         {
             return config_;
@@ -0,0 +1,759 @@
+/*
+ * daemon.h
+ * Resident regridding service over a Unix domain socket, caching targets and weights, in FastRegrid.
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#ifndef FASTREGRID_DAEMON_H
+#define FASTREGRID_DAEMON_H
+
+#include "config.h"
+#include "types.h"
+#include "grid_store.h"
+#include "io.h"
+#include "grid.h"
+#include "weights.h"
+#include "interpolation.h"
+#include "logger.h"
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <thread>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fastregrid
+{
+
+    // Least-recently-used cache of immutable values, bounded by the sum of the
+    // byte sizes given to put(). Values are shared, so evicting an entry never
+    // invalidates one that a caller is still using. Thread-safe.
+    template <typename Value>
+    class LruCache
+    {
+    public:
+        explicit LruCache(size_t capacity_bytes) : capacity_(capacity_bytes) {}
+
+        // Returns the value for key (marking it most recently used), or null.
+        std::shared_ptr<const Value> get(const std::string &key)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = index_.find(key);
+            if (it == index_.end())
+            {
+                ++misses_;
+                return nullptr;
+            }
+            ++hits_;
+            entries_.splice(entries_.begin(), entries_, it->second);
+            return it->second->value;
+        }
+
+        // Inserts or replaces key, then evicts least recently used entries until
+        // the cache fits its capacity (the new entry itself is always kept).
+        void put(const std::string &key, std::shared_ptr<const Value> value, size_t bytes)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = index_.find(key);
+            if (it != index_.end())
+            {
+                bytes_ -= it->second->bytes;
+                entries_.erase(it->second);
+                index_.erase(it);
+            }
+            entries_.push_front(Entry{key, std::move(value), bytes});
+            index_[key] = entries_.begin();
+            bytes_ += bytes;
+            while (bytes_ > capacity_ && entries_.size() > 1)
+            {
+                bytes_ -= entries_.back().bytes;
+                index_.erase(entries_.back().key);
+                entries_.pop_back();
+            }
+        }
+
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            entries_.clear();
+            index_.clear();
+            bytes_ = 0;
+        }
+
+        size_t size() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return entries_.size();
+        }
+
+        size_t bytes() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return bytes_;
+        }
+
+        size_t hits() const { return hits_.load(); }
+        size_t misses() const { return misses_.load(); }
+
+    private:
+        struct Entry
+        {
+            std::string key;
+            std::shared_ptr<const Value> value;
+            size_t bytes;
+        };
+
+        size_t capacity_;
+        size_t bytes_ = 0;
+        std::list<Entry> entries_;
+        std::unordered_map<std::string, typename std::list<Entry>::iterator> index_;
+        std::atomic<size_t> hits_{0};
+        std::atomic<size_t> misses_{0};
+        mutable std::mutex mutex_;
+    };
+
+#ifndef _WIN32
+
+    namespace protocol
+    {
+
+        // Largest accepted frame; requests are a few lines of text.
+        constexpr uint32_t MAX_FRAME_BYTES = 1u << 20;
+
+        // Layout of a result written to shared memory: this header, then rows
+        // doubles of longitude, rows doubles of latitude, rows int64 time steps
+        // and rows * stride values of value_bytes each.
+        struct ShmHeader
+        {
+            uint64_t magic; // SHM_MAGIC
+            uint64_t rows;
+            uint64_t stride;
+            uint64_t value_bytes; // sizeof(ValueType)
+        };
+        constexpr uint64_t SHM_MAGIC = 0x4652524547524944ULL; // "FRREGRID"
+
+        // Writes all of data to a socket, without raising SIGPIPE.
+        inline void send_all(int fd, const char *data, size_t size)
+        {
+            while (size > 0)
+            {
+#ifdef MSG_NOSIGNAL
+                ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+#else
+                ssize_t sent = send(fd, data, size, 0); // Callers ignore SIGPIPE instead
+#endif
+                if (sent < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (sent <= 0)
+                {
+                    throw std::runtime_error(std::string("Socket write failed: ") + std::strerror(errno));
+                }
+                data += sent;
+                size -= static_cast<size_t>(sent);
+            }
+        }
+
+        // Reads exactly size bytes; returns false on a clean end of stream before the first byte.
+        inline bool receive_all(int fd, char *data, size_t size)
+        {
+            size_t received = 0;
+            while (received < size)
+            {
+                ssize_t n = recv(fd, data + received, size - received, 0);
+                if (n < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (n == 0 && received == 0)
+                {
+                    return false;
+                }
+                if (n <= 0)
+                {
+                    throw std::runtime_error("Socket closed in the middle of a frame");
+                }
+                received += static_cast<size_t>(n);
+            }
+            return true;
+        }
+
+        // A frame is a 4-byte big-endian payload length followed by the payload.
+        inline void write_frame(int fd, const std::string &payload)
+        {
+            if (payload.size() > MAX_FRAME_BYTES)
+            {
+                throw std::runtime_error("Frame too large");
+            }
+            const uint32_t size = static_cast<uint32_t>(payload.size());
+            const char length[4] = {static_cast<char>(size >> 24), static_cast<char>(size >> 16),
+                                    static_cast<char>(size >> 8), static_cast<char>(size)};
+            send_all(fd, length, 4);
+            send_all(fd, payload.data(), payload.size());
+        }
+
+        // Returns false when the peer closed the connection between frames.
+        inline bool read_frame(int fd, std::string &payload)
+        {
+            unsigned char length[4];
+            if (!receive_all(fd, reinterpret_cast<char *>(length), 4))
+            {
+                return false;
+            }
+            const uint32_t size = (uint32_t(length[0]) << 24) | (uint32_t(length[1]) << 16) |
+                                  (uint32_t(length[2]) << 8) | uint32_t(length[3]);
+            if (size > MAX_FRAME_BYTES)
+            {
+                throw std::runtime_error("Frame too large");
+            }
+            payload.resize(size);
+            if (size > 0 && !receive_all(fd, &payload[0], size))
+            {
+                throw std::runtime_error("Socket closed in the middle of a frame");
+            }
+            return true;
+        }
+
+        // Sends one request to the daemon at socket_path and returns its response.
+        inline std::string request(const std::string &socket_path, const std::string &payload)
+        {
+            sockaddr_un address{};
+            if (socket_path.size() >= sizeof(address.sun_path))
+            {
+                throw std::invalid_argument("Socket path too long: " + socket_path);
+            }
+            address.sun_family = AF_UNIX;
+            std::strcpy(address.sun_path, socket_path.c_str());
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0)
+            {
+                throw std::runtime_error("Cannot create socket");
+            }
+            try
+            {
+                if (connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0)
+                {
+                    throw std::runtime_error("Cannot connect to daemon at: " + socket_path);
+                }
+                write_frame(fd, payload);
+                std::string response;
+                if (!read_frame(fd, response))
+                {
+                    throw std::runtime_error("Daemon closed the connection without a response");
+                }
+                close(fd);
+                return response;
+            }
+            catch (...)
+            {
+                close(fd);
+                throw;
+            }
+        }
+
+    } // namespace protocol
+
+    // Long-running regridding service. Clients connect to a Unix domain socket
+    // and exchange frames (see protocol::write_frame); a request is a command line
+    // followed by key=value lines:
+    //
+    //   REGRID                      PING | STATS | SHUTDOWN
+    //   source=<file>
+    //   target=<file>
+    //   output=<dir> or shm=<name>  (results as files, or in POSIX shared memory)
+    //   method=nn|idw  metric=haversine|euclidean  layout=grid_by_time|year_by_year
+    //   radius=  power=  min_points=  max_points=  precision=  (optional)
+    //
+    // and the response is "OK" or "ERROR" followed by key=value lines or the
+    // error message. Parsed target files (checked against their size and
+    // modification time) and weights (keyed by the grid fingerprints and the
+    // search settings) stay in one LRU cache, so a repeated job costs only the
+    // parse of its source values and the apply.
+    class RegridDaemon
+    {
+    public:
+        RegridDaemon(std::string socket_path, const RegridConfig &config, size_t cache_bytes = size_t(1) << 30,
+                     size_t max_clients = 16)
+            : socket_path_(std::move(socket_path)), config_(config), cache_(cache_bytes),
+              max_clients_(std::max<size_t>(1, max_clients))
+        {
+        }
+
+        RegridDaemon(const RegridDaemon &) = delete;
+        RegridDaemon &operator=(const RegridDaemon &) = delete;
+
+        ~RegridDaemon()
+        {
+            stop();
+            wait_for_clients();
+        }
+
+        // Listens until stop() is called or a SHUTDOWN request arrives. Each
+        // connection is served on its own thread (at most max_clients at once);
+        // regridding itself runs on the shared thread pool.
+        void serve()
+        {
+            sockaddr_un address{};
+            if (socket_path_.size() >= sizeof(address.sun_path))
+            {
+                throw std::invalid_argument("Socket path too long: " + socket_path_);
+            }
+            address.sun_family = AF_UNIX;
+            std::strcpy(address.sun_path, socket_path_.c_str());
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0)
+            {
+                throw std::runtime_error("Cannot create socket");
+            }
+            unlink(socket_path_.c_str());
+            const mode_t mask = umask(0077); // Socket usable by this user only
+            const int bound = bind(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address));
+            umask(mask);
+            if (bound != 0 || listen(fd, 64) != 0)
+            {
+                close(fd);
+                throw std::runtime_error("Cannot listen on socket: " + socket_path_);
+            }
+            if (config_.verbose)
+            {
+                std::cout << "Listening on: " << socket_path_ << std::endl;
+            }
+
+            while (!stopping_.load())
+            {
+                pollfd listener{fd, POLLIN, 0};
+                int ready = poll(&listener, 1, 200); // Wake up regularly to notice stop()
+                if (ready <= 0)
+                {
+                    continue;
+                }
+                int client = accept(fd, nullptr, nullptr);
+                if (client < 0)
+                {
+                    continue;
+                }
+                {
+                    std::unique_lock<std::mutex> lock(clients_mutex_);
+                    clients_done_.wait(lock, [this]()
+                                       { return active_clients_ < max_clients_; });
+                    ++active_clients_;
+                }
+                std::thread([this, client]()
+                            { serve_client(client); })
+                    .detach();
+            }
+            close(fd);
+            unlink(socket_path_.c_str());
+            wait_for_clients();
+        }
+
+        void stop() { stopping_.store(true); }
+
+        // Handles one request payload and returns the response payload.
+        std::string handle(const std::string &payload)
+        {
+            try
+            {
+                std::istringstream lines(payload);
+                std::string command;
+                std::getline(lines, command);
+                std::unordered_map<std::string, std::string> fields;
+                for (std::string line; std::getline(lines, line);)
+                {
+                    if (line.empty())
+                    {
+                        continue;
+                    }
+                    size_t equals = line.find('=');
+                    if (equals == std::string::npos)
+                    {
+                        throw std::invalid_argument("Expected key=value, got: " + line);
+                    }
+                    fields[line.substr(0, equals)] = line.substr(equals + 1);
+                }
+
+                if (command == "PING")
+                {
+                    return "OK\n";
+                }
+                if (command == "STATS")
+                {
+                    std::ostringstream out;
+                    out << "OK\nentries=" << cache_.size() << "\nbytes=" << cache_.bytes() << "\nhits=" << cache_.hits()
+                        << "\nmisses=" << cache_.misses() << "\nrequests=" << requests_.load() << '\n';
+                    return out.str();
+                }
+                if (command == "SHUTDOWN")
+                {
+                    stop();
+                    return "OK\n";
+                }
+                if (command == "REGRID")
+                {
+                    ++requests_;
+                    return regrid(fields);
+                }
+                throw std::invalid_argument("Unknown command: " + command);
+            }
+            catch (const std::exception &e)
+            {
+                return std::string("ERROR\n") + e.what() + '\n';
+            }
+        }
+
+    private:
+        // Parsed rows of a target file and their grid.
+        struct TargetEntry
+        {
+            off_t file_size = 0;
+            int64_t modified_ns = 0;
+            std::vector<std::string> headers;
+            GridStore rows; // Coordinates and time steps (stride 0)
+            std::vector<size_t> row_locations;
+            std::shared_ptr<const Grid> grid;
+        };
+
+        // Weights for one source grid and target grid under one search setting.
+        struct WeightsEntry
+        {
+            std::shared_ptr<const Grid> source_grid;
+            std::shared_ptr<const Grid> target_grid;
+            RegridWeights weights;
+        };
+
+        // Cache entries of both kinds share one LRU budget.
+        struct CacheEntry
+        {
+            std::shared_ptr<const TargetEntry> target;
+            std::shared_ptr<const WeightsEntry> weights;
+        };
+
+        void serve_client(int client)
+        {
+            try
+            {
+                std::string payload;
+                while (protocol::read_frame(client, payload))
+                {
+                    protocol::write_frame(client, handle(payload));
+                }
+            }
+            catch (const std::exception &e)
+            {
+                if (config_.verbose)
+                {
+                    log_warning("Dropping client connection: {}", e.what());
+                }
+            }
+            close(client);
+            std::lock_guard<std::mutex> lock(clients_mutex_); // Notify under the lock: the daemon may be destroyed right after
+            --active_clients_;
+            clients_done_.notify_all();
+        }
+
+        void wait_for_clients()
+        {
+            std::unique_lock<std::mutex> lock(clients_mutex_);
+            clients_done_.wait(lock, [this]()
+                               { return active_clients_ == 0; });
+        }
+
+        static const std::string &field(const std::unordered_map<std::string, std::string> &fields,
+                                        const std::string &key)
+        {
+            auto it = fields.find(key);
+            if (it == fields.end() || it->second.empty())
+            {
+                throw std::invalid_argument("Missing field: " + key);
+            }
+            return it->second;
+        }
+
+        // The daemon's config with the request's overrides applied.
+        RegridConfig request_config(const std::unordered_map<std::string, std::string> &fields) const
+        {
+            RegridConfigBuilder builder;
+            RegridConfig config = config_;
+            for (const auto &[key, value] : fields)
+            {
+                if (key == "method")
+                {
+                    if (value != "nn" && value != "idw")
+                    {
+                        throw std::invalid_argument("Unknown method: " + value);
+                    }
+                    config.interp_method = value == "nn" ? NEAREST_NEIGHBOR : INVERSE_DISTANCE_WEIGHTED;
+                }
+                else if (key == "metric")
+                {
+                    if (value != "haversine" && value != "euclidean")
+                    {
+                        throw std::invalid_argument("Unknown metric: " + value);
+                    }
+                    config.distance_metric = value == "haversine" ? HAVERSINE : EUCLIDEAN;
+                }
+                else if (key == "layout")
+                {
+                    if (value != "grid_by_time" && value != "year_by_year")
+                    {
+                        throw std::invalid_argument("Unknown layout: " + value);
+                    }
+                    config.data_layout = value == "grid_by_time" ? GRID_BY_TIME : YEAR_BY_YEAR;
+                }
+                else if (key == "radius")
+                {
+                    config.radius = builder.set_radius(std::stod(value)).build().radius;
+                }
+                else if (key == "power")
+                {
+                    config.power = builder.set_power(std::stod(value)).build().power;
+                }
+                else if (key == "min_points")
+                {
+                    config.min_points = std::stoi(value);
+                }
+                else if (key == "max_points")
+                {
+                    config.max_points = std::stoi(value);
+                }
+                else if (key == "precision")
+                {
+                    config.precision = builder.set_precision(std::stoi(value)).build().precision;
+                }
+                else if (key != "source" && key != "target" && key != "output" && key != "shm")
+                {
+                    throw std::invalid_argument("Unknown field: " + key);
+                }
+            }
+            if (config.max_points <= 0 || config.min_points <= 0 || config.min_points > config.max_points)
+            {
+                throw std::invalid_argument("Need 0 < min_points <= max_points");
+            }
+            config.write_mappings = false;
+            config.tile_size = 0.0;
+            return config;
+        }
+
+        std::shared_ptr<const TargetEntry> target(const std::string &filename, const RegridConfig &config)
+        {
+            struct stat info;
+            if (stat(filename.c_str(), &info) != 0)
+            {
+                throw std::runtime_error("Cannot open input file: " + filename);
+            }
+#ifdef __APPLE__
+            const timespec &modified = info.st_mtimespec;
+#else
+            const timespec &modified = info.st_mtim;
+#endif
+            const int64_t modified_ns = int64_t(modified.tv_sec) * 1000000000 + modified.tv_nsec;
+            const std::string key = "target|" + std::to_string(config.data_layout) + '|' +
+                                    std::to_string(config.adjust_longitude) + '|' + filename;
+            if (auto cached = cache_.get(key))
+            {
+                if (cached->target->file_size == info.st_size && cached->target->modified_ns == modified_ns)
+                {
+                    return cached->target;
+                }
+            }
+
+            auto entry = std::make_shared<TargetEntry>();
+            entry->file_size = info.st_size;
+            entry->modified_ns = modified_ns;
+            InputReader reader(filename, config);
+            entry->headers = reader.read_headers();
+            size_t stride = 0;
+            entry->rows = reader.read_locations(stride);
+            const LargeBufferPolicy policy = buffer_policy(config);
+            entry->grid = std::make_shared<const Grid>(entry->rows, policy, &entry->row_locations);
+            const size_t bytes = entry->rows.size() * (2 * sizeof(double) + sizeof(int) + sizeof(size_t)) +
+                                 entry->grid->size() * 2 * sizeof(double);
+            auto cached = std::make_shared<CacheEntry>();
+            cached->target = entry;
+            cache_.put(key, cached, bytes);
+            return entry;
+        }
+
+        std::shared_ptr<const WeightsEntry> weights(const std::shared_ptr<const Grid> &source_grid,
+                                                    const std::shared_ptr<const Grid> &target_grid,
+                                                    const RegridConfig &config, bool &hit)
+        {
+            std::ostringstream key;
+            key << "weights|" << std::hex << source_grid->fingerprint() << '|' << target_grid->fingerprint()
+                << std::dec << '|' << config.interp_method << '|' << config.distance_metric << '|' << config.adjust_longitude
+                << '|' << config.radius << '|' << config.power << '|' << config.min_points << '|' << config.max_points;
+            auto same = [](const Grid &a, const Grid &b)
+            {
+                return &a == &b || (a.longitudes() == b.longitudes() && a.latitudes() == b.latitudes());
+            };
+            if (auto cached = cache_.get(key.str()))
+            {
+                const WeightsEntry &entry = *cached->weights;
+                if (same(*entry.source_grid, *source_grid) && same(*entry.target_grid, *target_grid))
+                {
+                    hit = true;
+                    return cached->weights;
+                }
+            }
+
+            hit = false;
+            auto entry = std::make_shared<WeightsEntry>();
+            entry->source_grid = source_grid;
+            entry->target_grid = target_grid;
+            entry->weights = RegridWeights::build(source_grid->longitudes().data(), source_grid->latitudes().data(),
+                                                  source_grid->size(), target_grid->longitudes().data(),
+                                                  target_grid->latitudes().data(), target_grid->size(), config);
+            const size_t bytes = entry->weights.nonzeros() * (sizeof(size_t) + sizeof(ValueType)) +
+                                 entry->weights.target_size() * (sizeof(size_t) + 1) +
+                                 source_grid->size() * 2 * sizeof(double);
+            auto cached = std::make_shared<CacheEntry>();
+            cached->weights = entry;
+            cache_.put(key.str(), cached, bytes);
+            return entry;
+        }
+
+        std::string regrid(const std::unordered_map<std::string, std::string> &fields)
+        {
+            RegridConfig config = request_config(fields);
+            const std::string &source_file = field(fields, "source");
+            const bool to_shm = fields.count("shm") != 0;
+            if (to_shm == (fields.count("output") != 0))
+            {
+                throw std::invalid_argument("Give exactly one of output= and shm=");
+            }
+
+            auto target_entry = target(field(fields, "target"), config);
+            InputReader source_reader(source_file, config);
+            std::vector<std::string> headers = source_reader.read_headers();
+            validate_headers(headers, target_entry->headers, config);
+
+            const LargeBufferPolicy policy = buffer_policy(config);
+            Field source_field = [&]()
+            {
+                if (config.memory_budget != 0)
+                {
+                    return Field::load(source_file, config);
+                }
+                GridStore source_points = source_reader.read_grid();
+                auto grid = std::make_shared<const Grid>(source_points, policy);
+                return Field(source_points, grid, policy, &pool_for(config));
+            }();
+
+            bool hit = false;
+            auto weights_entry = weights(source_field.grid_ptr(), target_entry->grid, config, hit);
+            GridStore interpolated_points = Interpolator(source_field, config)
+                                                .interpolate_rows(target_entry->rows, target_entry->row_locations,
+                                                                  weights_entry->weights);
+            if (interpolated_points.empty())
+            {
+                throw std::runtime_error(config.interp_method == NEAREST_NEIGHBOR ? "No points interpolated in NN mode"
+                                                                                  : "No points interpolated in IDW mode");
+            }
+
+            std::ostringstream response;
+            response << "OK\nrows=" << interpolated_points.size() << "\nstride=" << interpolated_points.stride()
+                     << "\ncache=" << (hit ? "hit" : "miss") << '\n';
+            if (to_shm)
+            {
+                response << "bytes=" << write_shm(field(fields, "shm"), interpolated_points) << '\n';
+            }
+            else
+            {
+                config.output_path = field(fields, "output");
+                OutputWriter writer(config);
+                writer.write_gridlist(source_field.grid().longitudes(), source_field.grid().latitudes(),
+                                      "source_gridlist.txt");
+                writer.write_gridlist(target_entry->grid->longitudes(), target_entry->grid->latitudes(),
+                                      "target_gridlist.txt");
+                writer.write_regridded_data(interpolated_points, "regridded.txt", headers);
+                response << "path=" << writer.path("regridded.txt") << '\n';
+            }
+            return response.str();
+        }
+
+        // Writes points to the shared memory object name (see protocol::ShmHeader),
+        // replacing any previous one; the client unlinks it. Returns its size.
+        static size_t write_shm(const std::string &name, const GridStore &points)
+        {
+            if (name.size() < 2 || name[0] != '/' || name.find('/', 1) != std::string::npos)
+            {
+                throw std::invalid_argument("Shared memory name must look like /name: " + name);
+            }
+            const size_t rows = points.size();
+            const size_t bytes = sizeof(protocol::ShmHeader) + rows * (2 * sizeof(double) + sizeof(int64_t)) +
+                                 rows * points.stride() * sizeof(ValueType);
+            int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+            if (fd < 0)
+            {
+                throw std::runtime_error("Cannot open shared memory: " + name);
+            }
+            if (ftruncate(fd, static_cast<off_t>(bytes)) != 0)
+            {
+                close(fd);
+                throw std::runtime_error("Cannot size shared memory: " + name);
+            }
+            void *addr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            close(fd);
+            if (addr == MAP_FAILED)
+            {
+                throw std::runtime_error("Cannot map shared memory: " + name);
+            }
+            char *out = static_cast<char *>(addr);
+            const protocol::ShmHeader header{protocol::SHM_MAGIC, rows, points.stride(), sizeof(ValueType)};
+            std::memcpy(out, &header, sizeof(header));
+            out += sizeof(header);
+            std::memcpy(out, points.longitudes().data(), rows * sizeof(double));
+            out += rows * sizeof(double);
+            std::memcpy(out, points.latitudes().data(), rows * sizeof(double));
+            out += rows * sizeof(double);
+            for (size_t i = 0; i < rows; ++i, out += sizeof(int64_t))
+            {
+                const int64_t time_step = points.time_step(i);
+                std::memcpy(out, &time_step, sizeof(int64_t));
+            }
+            std::memcpy(out, points.value_buffer().data(), rows * points.stride() * sizeof(ValueType));
+            munmap(addr, bytes);
+            return bytes;
+        }
+
+        std::string socket_path_;
+        RegridConfig config_;
+        LruCache<CacheEntry> cache_;
+        size_t max_clients_;
+        std::atomic<bool> stopping_{false};
+        std::atomic<size_t> requests_{0};
+        std::mutex clients_mutex_;
+        std::condition_variable clients_done_;
+        size_t active_clients_ = 0;
+    };
+
+#endif // _WIN32
+
+} // namespace fastregrid
+
+#endif // FASTREGRID_DAEMON_H
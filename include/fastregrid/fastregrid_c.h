@@ -0,0 +1,94 @@
+/*
+ * fastregrid_c.h
+ * C interface to FastRegrid weights, callable from C and from Fortran via iso_c_binding.
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#ifndef FASTREGRID_C_H
+#define FASTREGRID_C_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Value type of the data arrays; must match the build (FASTREGRID_SINGLE_PRECISION). */
+#ifdef FASTREGRID_SINGLE_PRECISION
+    typedef float fastregrid_value_t;
+#else
+    typedef double fastregrid_value_t;
+#endif
+
+/* Status codes returned by the functions below. */
+#define FASTREGRID_OK 0
+#define FASTREGRID_ERROR_INVALID_ARGUMENT 1
+#define FASTREGRID_ERROR_NOT_BUILT 2
+#define FASTREGRID_ERROR_OUT_OF_MEMORY 3
+#define FASTREGRID_ERROR_RUNTIME 4
+
+/* Values of fastregrid_options.interp_method and .distance_metric (same as the C++ enums). */
+#define FASTREGRID_NEAREST_NEIGHBOR 0
+#define FASTREGRID_INVERSE_DISTANCE_WEIGHTED 1
+#define FASTREGRID_EUCLIDEAN 0
+#define FASTREGRID_HAVERSINE 1
+
+    /* Search settings used when building weights (subset of RegridConfig). */
+    typedef struct fastregrid_options
+    {
+        int32_t interp_method;
+        int32_t distance_metric;
+        double radius; /* km */
+        double power;
+        int32_t max_points;
+        int32_t min_points;
+        int32_t num_threads; /* 0 = all hardware threads */
+        int32_t verbose;
+    } fastregrid_options;
+
+    /* Opaque handle to a set of precomputed source -> target weights. */
+    typedef struct fastregrid_weights fastregrid_weights;
+
+    /* Fills options with the RegridConfig defaults. */
+    void fastregrid_default_options(fastregrid_options *options);
+
+    /* Returns a new, empty handle, or NULL if out of memory. */
+    fastregrid_weights *fastregrid_weights_create(void);
+
+    /* Frees a handle; NULL is ignored. */
+    void fastregrid_weights_destroy(fastregrid_weights *weights);
+
+    /* Builds weights from n_source source and n_target target coordinates (degrees).
+     * options may be NULL for defaults. Replaces any weights held by the handle. */
+    int fastregrid_weights_build(fastregrid_weights *weights,
+                                 const double *source_lons, const double *source_lats, int64_t n_source,
+                                 const double *target_lons, const double *target_lats, int64_t n_target,
+                                 const fastregrid_options *options);
+
+    int64_t fastregrid_weights_source_size(const fastregrid_weights *weights);
+    int64_t fastregrid_weights_target_size(const fastregrid_weights *weights);
+
+    /* Applies the weights to n_values columns of column-major arrays, in place of
+     * the caller's memory (no copies):
+     *   source_values(source_ld, n_values), source_ld >= n_source
+     *   target_values(target_ld, n_values), target_ld >= n_target
+     * This is the layout of a Fortran array values(n_locations, n_values). */
+    int fastregrid_weights_apply(const fastregrid_weights *weights,
+                                 const fastregrid_value_t *source_values, int64_t source_ld,
+                                 fastregrid_value_t *target_values, int64_t target_ld,
+                                 int64_t n_values);
+
+    /* Message of the last error on the calling thread ("" if none). */
+    const char *fastregrid_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FASTREGRID_C_H */
@@ -0,0 +1,446 @@
+/*
+ * grid.h
+ * Reusable grid geometry (Grid) and gridded values (Field) for FastRegrid.
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#ifndef FASTREGRID_GRID_H
+#define FASTREGRID_GRID_H
+
+#include "config.h"
+#include "types.h"
+#include "grid_store.h"
+#include "memory.h"
+#include "io.h"
+#include <vector>
+#include <string>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <cmath>
+#include <iostream>
+
+namespace fastregrid
+{
+
+    // Axis-aligned lon/lat lattice: location (i, j) is (lon0 + i * dlon, lat0 + j * dlat).
+    struct RegularGridDescriptor
+    {
+        double lon0;
+        double lat0;
+        double dlon;
+        double dlat;
+        size_t nlon;
+        size_t nlat;
+    };
+
+    // Immutable grid geometry: unique locations in first-seen order, an exact
+    // coordinate -> location lookup, a fingerprint and, when the locations form
+    // a full regular lattice, its descriptor. Share across threads as
+    // std::shared_ptr<const Grid>.
+    class Grid
+    {
+    public:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        // Builds a grid from the locations of rows. If row_locations is given it
+        // receives the location index of every row.
+        explicit Grid(const GridStore &rows, const LargeBufferPolicy &policy = LargeBufferPolicy(),
+                      std::vector<size_t> *row_locations = nullptr)
+            : longitude_(LargeBufferAllocator<double>(policy)),
+              latitude_(LargeBufferAllocator<double>(policy))
+        {
+            init(rows.longitudes().data(), rows.latitudes().data(), rows.size(), row_locations);
+        }
+
+        // Builds a grid from coordinate arrays of count locations (duplicates are merged).
+        Grid(const double *longitudes, const double *latitudes, size_t count,
+             const LargeBufferPolicy &policy = LargeBufferPolicy(),
+             std::vector<size_t> *row_locations = nullptr)
+            : longitude_(LargeBufferAllocator<double>(policy)),
+              latitude_(LargeBufferAllocator<double>(policy))
+        {
+            init(longitudes, latitudes, count, row_locations);
+        }
+
+        // Reads the locations of a source or target file (values are not parsed).
+        static std::shared_ptr<const Grid> load(const std::string &filename, const RegridConfig &config)
+        {
+            GridStore rows(0, buffer_policy(config));
+            InputReader(filename, config).scan_locations([&rows](double lon, double lat, int time_step)
+                                                         { rows.push_back(lon, lat, time_step); });
+            if (rows.empty())
+            {
+                throw std::runtime_error("Empty input file: " + filename);
+            }
+            return std::make_shared<const Grid>(rows, buffer_policy(config));
+        }
+
+        size_t size() const { return longitude_.size(); }
+        double longitude(size_t location) const { return longitude_[location]; }
+        double latitude(size_t location) const { return latitude_[location]; }
+        const LargeVector<double> &longitudes() const { return longitude_; }
+        const LargeVector<double> &latitudes() const { return latitude_; }
+
+        // Set when the locations form a complete regular lattice.
+        const std::optional<RegularGridDescriptor> &regular() const { return regular_; }
+
+        // Hash of the location coordinates (at 1e-6 degree resolution) in order.
+        uint64_t fingerprint() const { return fingerprint_; }
+
+        // Location index of (lon, lat), or npos.
+        size_t find(double lon, double lat) const
+        {
+            auto it = lookup_.find(key(lon, lat));
+            return it == lookup_.end() ? npos : it->second;
+        }
+
+    private:
+        // Coordinates are matched at 1e-6 degree resolution; |lon| <= 360 and
+        // |lat| <= 90 fit exactly into the two 32-bit halves of the key.
+        static int64_t quantize(double degrees)
+        {
+            return static_cast<int64_t>(std::llround(degrees * 1e6));
+        }
+
+        static uint64_t key(double lon, double lat)
+        {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(quantize(lon))) << 32) |
+                   static_cast<uint32_t>(quantize(lat));
+        }
+
+        void init(const double *longitudes, const double *latitudes, size_t count, std::vector<size_t> *row_locations)
+        {
+            if (row_locations)
+            {
+                row_locations->resize(count);
+            }
+            lookup_.reserve(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                auto [it, inserted] = lookup_.emplace(key(longitudes[i], latitudes[i]), longitude_.size());
+                if (inserted)
+                {
+                    longitude_.push_back(longitudes[i]);
+                    latitude_.push_back(latitudes[i]);
+                }
+                if (row_locations)
+                {
+                    (*row_locations)[i] = it->second;
+                }
+            }
+            compute_fingerprint();
+            detect_regular();
+        }
+
+        // FNV-1a over the quantized coordinates.
+        void compute_fingerprint()
+        {
+            uint64_t hash = 1469598103934665603ULL;
+            auto mix = [&hash](uint64_t value)
+            {
+                for (int byte = 0; byte < 8; ++byte)
+                {
+                    hash ^= (value >> (8 * byte)) & 0xff;
+                    hash *= 1099511628211ULL;
+                }
+            };
+            mix(size());
+            for (size_t i = 0; i < size(); ++i)
+            {
+                mix(static_cast<uint64_t>(quantize(longitude_[i])));
+                mix(static_cast<uint64_t>(quantize(latitude_[i])));
+            }
+            fingerprint_ = hash;
+        }
+
+        // Sorted unique axis values, or empty if they are not evenly spaced.
+        static std::vector<int64_t> regular_axis(const LargeVector<double> &values)
+        {
+            std::vector<int64_t> axis;
+            axis.reserve(values.size());
+            for (double value : values)
+            {
+                axis.push_back(quantize(value));
+            }
+            std::sort(axis.begin(), axis.end());
+            axis.erase(std::unique(axis.begin(), axis.end()), axis.end());
+            for (size_t i = 2; i < axis.size(); ++i)
+            {
+                if (axis[i] - axis[i - 1] != axis[1] - axis[0])
+                {
+                    return {};
+                }
+            }
+            return axis;
+        }
+
+        void detect_regular()
+        {
+            if (size() < 2)
+            {
+                return;
+            }
+            std::vector<int64_t> lons = regular_axis(longitude_);
+            std::vector<int64_t> lats = regular_axis(latitude_);
+            if (lons.empty() || lats.empty() || lons.size() * lats.size() != size())
+            {
+                return;
+            }
+            RegularGridDescriptor descriptor;
+            descriptor.lon0 = lons[0] * 1e-6;
+            descriptor.lat0 = lats[0] * 1e-6;
+            descriptor.dlon = lons.size() > 1 ? (lons[1] - lons[0]) * 1e-6 : 0.0;
+            descriptor.dlat = lats.size() > 1 ? (lats[1] - lats[0]) * 1e-6 : 0.0;
+            descriptor.nlon = lons.size();
+            descriptor.nlat = lats.size();
+            regular_ = descriptor;
+        }
+
+        LargeVector<double> longitude_;
+        LargeVector<double> latitude_;
+        std::unordered_map<uint64_t, size_t> lookup_;
+        std::optional<RegularGridDescriptor> regular_;
+        uint64_t fingerprint_ = 0;
+    };
+
+    // Values over a Grid x time axis, with a presence flag per (time, location),
+    // since inputs may not provide every location for every time step. Stored
+    // dense in memory as [time][location][stride], or, when spilled to disk,
+    // as [block][time][stride] with locations assigned to blocks in Z-order so
+    // that spatially close locations share pages.
+    class Field
+    {
+    public:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        // Scatters rows onto grid; every row location must belong to grid.
+        // Duplicate (location, time step) rows keep the first occurrence.
+        Field(const GridStore &rows, std::shared_ptr<const Grid> grid,
+              const LargeBufferPolicy &policy = LargeBufferPolicy(), ThreadPool *pool = nullptr)
+            : Field(std::move(grid), sorted_time_steps(rows), rows.stride(), policy, pool, nullptr)
+        {
+            for (size_t row = 0; row < rows.size(); ++row)
+            {
+                size_t location = grid_->find(rows.longitude(row), rows.latitude(row));
+                if (location == Grid::npos)
+                {
+                    throw std::runtime_error("Field row at (" + std::to_string(rows.longitude(row)) + ", " +
+                                             std::to_string(rows.latitude(row)) + ") is not on the grid");
+                }
+                insert(time_index(rows.time_step(row)), location, rows.values(row));
+            }
+        }
+
+        Field(const Field &) = delete;
+        Field &operator=(const Field &) = delete;
+        Field(Field &&) = default;
+        Field &operator=(Field &&) = default;
+
+        // Reads a source file onto an existing grid.
+        static Field load(const std::string &filename, std::shared_ptr<const Grid> grid, const RegridConfig &config)
+        {
+            GridStore rows = InputReader(filename, config).read_grid();
+            return Field(rows, std::move(grid), buffer_policy(config), &pool_for(config));
+        }
+
+        // Reads a source file and its grid within config.memory_budget: the file is
+        // parsed twice (locations, then values) so no row copy of the values is ever
+        // held, and values that would exceed the budget are spilled to a temporary
+        // file under config.spill_path. The number of rows read is stored in rows_read.
+        static Field load(const std::string &filename, const RegridConfig &config, size_t *rows_read = nullptr)
+        {
+            return load(filename, config, nullptr, rows_read);
+        }
+
+        // As above, but keeps only the values at the time steps in kept (e.g. those
+        // of one shard's target rows); the grid still holds every source location.
+        static Field load(const std::string &filename, const RegridConfig &config,
+                          const std::unordered_set<int> &kept, size_t *rows_read = nullptr)
+        {
+            return load(filename, config, &kept, rows_read);
+        }
+
+        const Grid &grid() const { return *grid_; }
+        const std::shared_ptr<const Grid> &grid_ptr() const { return grid_; }
+        size_t stride() const { return stride_; }
+        const std::vector<int> &time_steps() const { return time_steps_; }
+
+        // True if values live in a spill file rather than in memory.
+        bool spilled() const { return !block_.empty(); }
+
+        // Position of time_step on the time axis, or npos.
+        size_t time_index(int time_step) const
+        {
+            auto it = std::lower_bound(time_steps_.begin(), time_steps_.end(), time_step);
+            return (it == time_steps_.end() || *it != time_step) ? npos : static_cast<size_t>(it - time_steps_.begin());
+        }
+
+        bool has(size_t time_idx, size_t location) const
+        {
+            return present_data_[slot(time_idx, location)] != 0;
+        }
+
+        const ValueType *values(size_t time_idx, size_t location) const
+        {
+            return values_data_ + slot(time_idx, location) * stride_;
+        }
+
+    private:
+        // Two-pass load; keeps every time step if kept is null.
+        static Field load(const std::string &filename, const RegridConfig &config,
+                          const std::unordered_set<int> *kept, size_t *rows_read)
+        {
+            InputReader reader(filename, config);
+            const LargeBufferPolicy policy = buffer_policy(config);
+            size_t stride = 0;
+            std::vector<size_t> row_locations;
+            std::vector<size_t> row_times;
+            std::shared_ptr<const Grid> grid;
+            std::vector<int> time_steps;
+            {
+                GridStore locations = reader.read_locations(stride);
+                grid = std::make_shared<const Grid>(locations, policy, &row_locations);
+                time_steps = sorted_time_steps(locations);
+                if (kept)
+                {
+                    time_steps.erase(std::remove_if(time_steps.begin(), time_steps.end(), [kept](int time_step)
+                                                    { return kept->count(time_step) == 0; }),
+                                     time_steps.end());
+                }
+                row_times.resize(locations.size());
+                for (size_t row = 0; row < locations.size(); ++row)
+                {
+                    auto it = std::lower_bound(time_steps.begin(), time_steps.end(), locations.time_step(row));
+                    row_times[row] = (it == time_steps.end() || *it != locations.time_step(row))
+                                         ? npos
+                                         : static_cast<size_t>(it - time_steps.begin());
+                }
+            }
+
+            const size_t bytes = time_steps.size() * grid->size() * (stride * sizeof(ValueType) + 1);
+            const bool spill = config.memory_budget != 0 && bytes > config.memory_budget;
+            if (spill && config.verbose)
+            {
+                std::cout << "Source values (" << (bytes >> 20) << " MiB) exceed the memory budget ("
+                          << (config.memory_budget >> 20) << " MiB); spilling to disk" << std::endl;
+            }
+            Field field(std::move(grid), std::move(time_steps), stride, policy,
+                        &pool_for(config), spill ? &config.spill_path : nullptr);
+            size_t row = 0;
+            reader.scan([&](double, double, int, const ValueType *values, size_t)
+                        {
+                            if (row_times[row] != npos)
+                            {
+                                field.insert(row_times[row], row_locations[row], values);
+                            }
+                            ++row; });
+            if (row != row_locations.size())
+            {
+                throw std::runtime_error("Input file changed while reading: " + filename);
+            }
+            if (rows_read)
+            {
+                *rows_read = row;
+            }
+            return field;
+        }
+
+        // Allocates all-absent storage; spills to a file in *spill_path if given.
+        Field(std::shared_ptr<const Grid> grid, std::vector<int> time_steps, size_t stride,
+              const LargeBufferPolicy &policy, ThreadPool *pool, const std::string *spill_path)
+            : grid_(std::move(grid)),
+              stride_(stride),
+              time_steps_(std::move(time_steps)),
+              values_(LargeBufferAllocator<ValueType>(policy)),
+              present_(LargeBufferAllocator<uint8_t>(policy))
+        {
+            if (!grid_)
+            {
+                throw std::invalid_argument("Field requires a grid");
+            }
+            const size_t slots = time_steps_.size() * grid_->size();
+            if (spill_path)
+            {
+                // Blocks follow the Z-order of locations; each block holds every time step
+                block_.resize(grid_->size());
+                std::vector<std::pair<uint64_t, size_t>> order(grid_->size());
+                for (size_t i = 0; i < grid_->size(); ++i)
+                {
+                    order[i] = {utils::morton_key(grid_->longitude(i), grid_->latitude(i)), i};
+                }
+                std::sort(order.begin(), order.end());
+                for (size_t b = 0; b < order.size(); ++b)
+                {
+                    block_[order[b].second] = b;
+                }
+                time_pitch_ = 1;
+                location_pitch_ = time_steps_.size();
+                // Sparse file: untouched pages read back as zeros (absent)
+                spill_ = memory::SpillFile(slots * (stride_ * sizeof(ValueType) + 1), *spill_path);
+                values_data_ = static_cast<ValueType *>(spill_.data());
+                present_data_ = reinterpret_cast<uint8_t *>(values_data_ + slots * stride_);
+            }
+            else
+            {
+                time_pitch_ = grid_->size();
+                location_pitch_ = 1;
+                values_.resize(slots * stride_);
+                present_.resize(slots);
+                memory::first_touch(values_.data(), values_.size(), pool);
+                memory::first_touch(present_.data(), present_.size(), pool);
+                values_data_ = values_.data();
+                present_data_ = present_.data();
+            }
+        }
+
+        static std::vector<int> sorted_time_steps(const GridStore &rows)
+        {
+            std::vector<int> time_steps(rows.time_steps().begin(), rows.time_steps().end());
+            std::sort(time_steps.begin(), time_steps.end());
+            time_steps.erase(std::unique(time_steps.begin(), time_steps.end()), time_steps.end());
+            return time_steps;
+        }
+
+        size_t slot(size_t time_idx, size_t location) const
+        {
+            return time_idx * time_pitch_ + (block_.empty() ? location : block_[location]) * location_pitch_;
+        }
+
+        // Stores values unless the slot is already present (first occurrence wins).
+        void insert(size_t time_idx, size_t location, const ValueType *values)
+        {
+            const size_t index = slot(time_idx, location);
+            if (present_data_[index])
+            {
+                return;
+            }
+            present_data_[index] = 1;
+            std::copy(values, values + stride_, values_data_ + index * stride_);
+        }
+
+        std::shared_ptr<const Grid> grid_;
+        size_t stride_;
+        std::vector<int> time_steps_;
+        size_t time_pitch_ = 0;     // Slots between consecutive time steps of a location
+        size_t location_pitch_ = 0; // Slots between consecutive locations (blocks) of a time step
+        std::vector<size_t> block_; // Spilled only: block of each location
+        LargeVector<ValueType> values_;
+        LargeVector<uint8_t> present_;
+        memory::SpillFile spill_;
+        ValueType *values_data_ = nullptr;
+        uint8_t *present_data_ = nullptr;
+    };
+
+} // namespace fastregrid
+
+#endif // FASTREGRID_GRID_H
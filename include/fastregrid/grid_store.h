@@ -0,0 +1,176 @@
+/*
+ * grid_store.h
+ * Structure-of-arrays storage for geospatial rows in FastRegrid.
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#ifndef FASTREGRID_GRID_STORE_H
+#define FASTREGRID_GRID_STORE_H
+
+#include "types.h"
+#include "memory.h"
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <cstddef>
+
+namespace fastregrid
+{
+
+    // Stores rows (lon, lat, time_step, values) as contiguous columns.
+    // Values of all rows live in one flat buffer with a fixed stride, so row i
+    // occupies values[i * stride, (i + 1) * stride).
+    class GridStore
+    {
+    public:
+        GridStore() = default;
+        explicit GridStore(size_t stride, const LargeBufferPolicy &policy = LargeBufferPolicy())
+            : stride_(stride),
+              longitude_(LargeBufferAllocator<double>(policy)),
+              latitude_(LargeBufferAllocator<double>(policy)),
+              time_step_(LargeBufferAllocator<int>(policy)),
+              values_(LargeBufferAllocator<ValueType>(policy))
+        {
+        }
+
+        size_t size() const { return time_step_.size(); }
+        bool empty() const { return time_step_.empty(); }
+        size_t stride() const { return stride_; }
+
+        // Sets the number of values per row. Only allowed while the store is empty.
+        void set_stride(size_t stride)
+        {
+            if (!empty() && stride != stride_)
+            {
+                throw std::runtime_error("Cannot change stride of a non-empty GridStore");
+            }
+            stride_ = stride;
+        }
+
+        void reserve(size_t rows)
+        {
+            longitude_.reserve(rows);
+            latitude_.reserve(rows);
+            time_step_.reserve(rows);
+            values_.reserve(rows * stride_);
+        }
+
+        // Resizes to rows. New rows are zero-filled on pool (if given) in
+        // contiguous partitions (first touch), matching parallel row processing.
+        void resize(size_t rows, ThreadPool *pool = nullptr)
+        {
+            size_t old_rows = size();
+            longitude_.resize(rows);
+            latitude_.resize(rows);
+            time_step_.resize(rows);
+            values_.resize(rows * stride_);
+            if (rows > old_rows)
+            {
+                size_t added = rows - old_rows;
+                memory::first_touch(longitude_.data() + old_rows, added, pool);
+                memory::first_touch(latitude_.data() + old_rows, added, pool);
+                memory::first_touch(time_step_.data() + old_rows, added, pool);
+                memory::first_touch(values_.data() + old_rows * stride_, added * stride_, pool);
+            }
+        }
+
+        // Sets the coordinates and time step of an existing row.
+        void set_row(size_t row, double lon, double lat, int time_step)
+        {
+            longitude_[row] = lon;
+            latitude_[row] = lat;
+            time_step_[row] = time_step;
+        }
+
+        void clear()
+        {
+            longitude_.clear();
+            latitude_.clear();
+            time_step_.clear();
+            values_.clear();
+        }
+
+        // Appends a row; values must point to stride() elements.
+        void push_back(double lon, double lat, int time_step, const ValueType *values)
+        {
+            longitude_.push_back(lon);
+            latitude_.push_back(lat);
+            time_step_.push_back(time_step);
+            values_.insert(values_.end(), values, values + stride_);
+        }
+
+        // Appends a row with zero-initialized values, returning its index.
+        size_t push_back(double lon, double lat, int time_step)
+        {
+            longitude_.push_back(lon);
+            latitude_.push_back(lat);
+            time_step_.push_back(time_step);
+            values_.resize(values_.size() + stride_, ValueType(0));
+            return size() - 1;
+        }
+
+        double longitude(size_t row) const { return longitude_[row]; }
+        double latitude(size_t row) const { return latitude_[row]; }
+        int time_step(size_t row) const { return time_step_[row]; }
+        const ValueType *values(size_t row) const { return values_.data() + row * stride_; }
+        ValueType *values(size_t row) { return values_.data() + row * stride_; }
+
+        const LargeVector<double> &longitudes() const { return longitude_; }
+        const LargeVector<double> &latitudes() const { return latitude_; }
+        const LargeVector<int> &time_steps() const { return time_step_; }
+        const LargeVector<ValueType> &value_buffer() const { return values_; }
+
+        // Compatibility view: materializes row as a SpatialData.
+        SpatialData view(size_t row) const
+        {
+            SpatialData point;
+            point.gridPoint.longitude = longitude_[row];
+            point.gridPoint.latitude = latitude_[row];
+            point.time_step = time_step_[row];
+            point.values.assign(values(row), values(row) + stride_);
+            return point;
+        }
+
+        std::vector<SpatialData> to_spatial_data() const
+        {
+            std::vector<SpatialData> points;
+            points.reserve(size());
+            for (size_t i = 0; i < size(); ++i)
+            {
+                points.push_back(view(i));
+            }
+            return points;
+        }
+
+        static GridStore from_spatial_data(const std::vector<SpatialData> &points)
+        {
+            GridStore store(points.empty() ? 0 : points[0].values.size());
+            store.reserve(points.size());
+            for (const auto &point : points)
+            {
+                if (point.values.size() != store.stride())
+                {
+                    throw std::runtime_error("Inconsistent value sizes in spatial data");
+                }
+                size_t row = store.push_back(point.gridPoint.longitude, point.gridPoint.latitude, point.time_step);
+                std::copy(point.values.begin(), point.values.end(), store.values(row));
+            }
+            return store;
+        }
+
+    private:
+        size_t stride_ = 0;
+        LargeVector<double> longitude_;
+        LargeVector<double> latitude_;
+        LargeVector<int> time_step_;
+        LargeVector<ValueType> values_;
+    };
+
+} // namespace fastregrid
+
+#endif // FASTREGRID_GRID_STORE_H
@@ -14,10 +14,22 @@
 
 #include "config.h"
 #include "types.h"
+#include "grid_store.h"
+#include "grid.h"
+#include "weights.h"
+#include "thread_pool.h"
+#include "memory.h"
+#include "utils.h"
+#include "logger.h"
+#include "warnings.h"
+#include "trace.h"
 #include <vector>
+#include <tuple>
 #include <stdexcept>
 #include <iostream>
 #include <cmath>
+#include <algorithm>
+#include <cstdint>
 
 namespace fastregrid
 {
@@ -25,37 +37,34 @@ namespace fastregrid
     class Interpolator
     {
     public:
-        explicit Interpolator(const std::vector<SpatialData> &source_points, const RegridConfig &config)
-            : source_points_(source_points), config_(config)
+        // Warnings are tallied into warnings if given, else into the interpolator's own summary.
+        explicit Interpolator(const Field &source, const RegridConfig &config, WarningSummary *warnings = nullptr)
+            : source_(source), config_(config), own_warnings_(config.radius, config.warning_examples),
+              warnings_(warnings ? warnings : &own_warnings_)
         {
-            if (source_points_.empty())
+            if (source_.grid().size() == 0)
             {
                 throw std::runtime_error("Source point list is empty");
             }
-            // Validate value sizes
-            size_t value_size = source_points_[0].values.size();
-            for (const auto &point : source_points_)
-            {
-                if (point.values.size() != value_size)
-                {
-                    throw std::runtime_error("Inconsistent value sizes in source points");
-                }
-            }
         }
 
-        // Main interpolation function
-        std::vector<SpatialData> interpolate(
-            const std::vector<SpatialData> &target_points,
-            const std::vector<std::tuple<double, double, double, double, double, size_t>> &nn_mappings,
-            const std::vector<std::tuple<double, double, std::vector<std::tuple<double, double, double>>, size_t, bool>> &idw_mappings) const
+        // Main interpolation function. Mappings are per target grid location;
+        // row_locations gives the location of every target row.
+        GridStore interpolate(
+            const GridStore &target_points,
+            const std::vector<size_t> &row_locations,
+            const std::vector<NNMapping> &nn_mappings,
+            const std::vector<IDWMapping> &idw_mappings) const
         {
             if (config_.interp_method == NEAREST_NEIGHBOR)
             {
-                return interpolate_nearest_neighbor(target_points, nn_mappings);
+                return interpolate(target_points, row_locations,
+                                   RegridWeights(nn_mappings, source_.grid().size(), buffer_policy(config_)));
             }
             else if (config_.interp_method == INVERSE_DISTANCE_WEIGHTED)
             {
-                return interpolate_idw(target_points, idw_mappings);
+                return interpolate(target_points, row_locations,
+                                   RegridWeights(idw_mappings, config_.power, source_.grid().size(), buffer_policy(config_)));
             }
             else
             {
@@ -63,174 +72,150 @@ namespace fastregrid
             }
         }
 
-    private:
-        // Finds source point and copies its values to the interpolated point
-        bool find_and_copy_source_values(
-            const SpatialData &target,
-            double source_lon,
-            double source_lat,
-            SpatialData &interpolated) const
+        // Applies precomputed weights (targets = target grid locations) to every
+        // target row at its time step. Sources missing at that time step are
+        // skipped; rows with no present source are dropped.
+        GridStore interpolate(
+            const GridStore &target_points,
+            const std::vector<size_t> &row_locations,
+            const RegridWeights &weights) const
         {
-            for (const auto &src : source_points_)
-            {
-                if (std::abs(src.gridPoint.longitude - source_lon) < 1e-6 &&
-                    std::abs(src.gridPoint.latitude - source_lat) < 1e-6 &&
-                    src.time_step == target.time_step)
-                {
-                    interpolated.values = src.values;
-                    return true;
-                }
-            }
-            if (config_.verbose)
+            GridStore result = interpolate_rows(target_points, row_locations, weights);
+            if (result.empty())
             {
-                std::cerr << "Warning: No source point found for target ("
-                          << target.gridPoint.longitude << ", " << target.gridPoint.latitude << ", " << target.time_step
-                          << ") at source (" << source_lon << ", " << source_lat << ")" << std::endl;
+                throw std::runtime_error(config_.interp_method == NEAREST_NEIGHBOR ? "No points interpolated in NN mode"
+                                                                                   : "No points interpolated in IDW mode");
             }
-            return false;
+            return result;
         }
 
-        // Nearest Neighbor interpolation
-        std::vector<SpatialData> interpolate_nearest_neighbor(
-            const std::vector<SpatialData> &target_points,
-            const std::vector<std::tuple<double, double, double, double, double, size_t>> &mappings) const
+        // As interpolate(), but an empty result is not an error (e.g. for one tile).
+        GridStore interpolate_rows(
+            const GridStore &target_points,
+            const std::vector<size_t> &row_locations,
+            const RegridWeights &weights) const
         {
-            std::vector<SpatialData> result;
-            result.reserve(target_points.size());
-
-            for (const auto &mapping : mappings)
+            if (row_locations.size() != target_points.size())
             {
-                auto [target_lon, target_lat, source_lon, source_lat, distance, target_idx] = mapping;
-                if (target_idx >= target_points.size())
-                {
-                    throw std::runtime_error("Invalid target index in NN mapping");
-                }
-                const auto &target = target_points[target_idx];
-
-                SpatialData interpolated = target;
-                if (find_and_copy_source_values(target, source_lon, source_lat, interpolated))
-                {
-                    result.push_back(interpolated);
-                }
+                throw std::runtime_error("Target row locations do not match target rows");
             }
-
-            if (result.empty())
+            if (weights.source_size() != source_.grid().size())
             {
-                throw std::runtime_error("No points interpolated in NN mode");
+                throw std::runtime_error("Weights do not match the source grid");
             }
-            return result;
-        }
 
-        // IDW interpolation with fallback to Nearest Neighbor
-        std::vector<SpatialData> interpolate_idw(
-            const std::vector<SpatialData> &target_points,
-            const std::vector<std::tuple<double, double, std::vector<std::tuple<double, double, double>>, size_t, bool>> &mappings) const
-        {
-            std::vector<SpatialData> result;
-            result.reserve(target_points.size());
-
-            for (const auto &mapping : mappings)
+            const size_t stride = source_.stride();
+            GridStore result(stride, buffer_policy(config_));
+            ThreadPool &pool = pool_for(config_);
+            result.resize(target_points.size(), &pool);
+            std::vector<uint8_t> kept(target_points.size(), 0);
+
+            // Spilled sources are laid out in Z-order; visiting targets in the same
+            // order keeps page-ins of the spill file close to sequential. Only the
+            // rows passed in are reordered: the streaming pipeline calls this once
+            // per chunk of chunk_size rows, so across chunks page-ins follow the
+            // target file's order. Tiled mode (tile_size) groups targets spatially
+            // over the whole run.
+            std::vector<size_t> order(target_points.size());
+            for (size_t i = 0; i < order.size(); ++i)
+            {
+                order[i] = i;
+            }
+            if (source_.spilled())
             {
-                auto [target_lon, target_lat, sources, target_idx, is_fallback] = mapping;
-                if (target_idx >= target_points.size())
+                std::vector<uint64_t> keys(target_points.size());
+                for (size_t i = 0; i < keys.size(); ++i)
                 {
-                    throw std::runtime_error("Invalid target index in IDW mapping");
+                    keys[i] = utils::morton_key(target_points.longitude(i), target_points.latitude(i));
                 }
-                const auto &target = target_points[target_idx];
-
-                SpatialData interpolated = target;
-                interpolated.values.clear();
+                std::stable_sort(order.begin(), order.end(), [&keys](size_t a, size_t b)
+                                 { return keys[a] < keys[b]; });
+            }
 
-                if (is_fallback)
+            pool.parallel_for(0, order.size(), pool.grain(order.size(), config_.chunk_size), [&](size_t begin, size_t end)
+                              {
+                trace::Scope scope("interpolate task", "begin", begin);
+                WarningTallies tallies;
+                for (size_t i = begin; i < end; ++i)
                 {
-                    // Nearest Neighbor fallback (single source)
-                    if (sources.size() != 1)
+                    const size_t target_idx = order[i];
+                    size_t location = row_locations[target_idx];
+                    if (location >= weights.target_size())
                     {
-                        throw std::runtime_error("Invalid fallback mapping: expected one source point");
+                        throw std::runtime_error("Invalid target index in mapping");
                     }
-                    auto [source_lon, source_lat, distance] = sources[0];
-                    if (find_and_copy_source_values(target, source_lon, source_lat, interpolated))
-                    {
-                        result.push_back(interpolated);
-                    }
-                }
-                else
-                {
-                    // IDW interpolation
-                    std::vector<double> weights;
-                    std::vector<const SpatialData *> source_points;
-                    weights.reserve(sources.size());
-                    source_points.reserve(sources.size());
-
-                    // Collect source points and weights
-                    for (const auto &[source_lon, source_lat, distance] : sources)
+                    const int time_step = target_points.time_step(target_idx);
+                    const size_t time_idx = source_.time_index(time_step);
+
+                    ValueType *values = result.values(target_idx);
+                    ValueType weight_sum = 0;
+                    for (size_t k = weights.begin(location); k < weights.end(location); ++k)
                     {
-                        const SpatialData *source = nullptr;
-                        for (const auto &src : source_points_)
-                        {
-                            if (std::abs(src.gridPoint.longitude - source_lon) < 1e-6 &&
-                                std::abs(src.gridPoint.latitude - source_lat) < 1e-6 &&
-                                src.time_step == target.time_step)
-                            {
-                                source = &src;
-                                break;
-                            }
-                        }
-                        if (!source)
+                        const size_t source_location = weights.source(k);
+                        if (time_idx == Field::npos || !source_.has(time_idx, source_location))
                         {
                             if (config_.verbose)
                             {
-                                std::cerr << "Warning: No source point found for ("
-                                          << source_lon << ", " << source_lat << ", " << target.time_step
-                                          << ") in IDW interpolation" << std::endl;
+                                tallies[WARNING_MISSING_SOURCE_VALUE].add(target_points.longitude(target_idx),
+                                                                          target_points.latitude(target_idx),
+                                                                          std::numeric_limits<double>::quiet_NaN(),
+                                                                          config_.radius);
+                                if (warnings_->example(WARNING_MISSING_SOURCE_VALUE))
+                                {
+                                    log_warning("No source point found for target ({}, {}, {}) at source ({}, {})",
+                                                target_points.longitude(target_idx), target_points.latitude(target_idx),
+                                                time_step, source_.grid().longitude(source_location),
+                                                source_.grid().latitude(source_location));
+                                }
                             }
                             continue;
                         }
-                        double weight = distance > 1e-6 ? 1.0 / std::pow(distance, config_.power) : 1e6; // Avoid division by zero
-                        weights.push_back(weight);
-                        source_points.push_back(source);
-                    }
-
-                    if (source_points.empty())
-                    {
-                        if (config_.verbose)
+                        const ValueType w = weights.weight(k);
+                        const ValueType *source_values = source_.values(time_idx, source_location);
+                        weight_sum += w;
+                        for (size_t j = 0; j < stride; ++j)
                         {
-                            std::cerr << "Warning: No valid source points for target ("
-                                      << target_lon << ", " << target_lat << ", " << target.time_step
-                                      << ") in IDW interpolation" << std::endl;
+                            values[j] += w * source_values[j];
                         }
-                        continue;
                     }
 
-                    // Initialize interpolated values
-                    interpolated.values.resize(source_points[0]->values.size(), 0.0);
-                    double weight_sum = 0.0;
-                    for (size_t i = 0; i < source_points.size(); ++i)
+                    if (weight_sum == 0)
                     {
-                        weight_sum += weights[i];
-                        for (size_t j = 0; j < interpolated.values.size(); ++j)
-                        {
-                            interpolated.values[j] += weights[i] * source_points[i]->values[j];
-                        }
+                        continue; // Row is dropped below
                     }
-                    for (auto &value : interpolated.values)
+                    for (size_t j = 0; j < stride; ++j)
                     {
-                        value /= weight_sum;
+                        values[j] /= weight_sum;
                     }
-                    result.push_back(interpolated);
+                    kept[target_idx] = 1;
                 }
-            }
+                warnings_->merge(tallies); });
 
-            if (result.empty())
+            // Compact kept rows, preserving target row order
+            size_t out = 0;
+            for (size_t target_idx = 0; target_idx < target_points.size(); ++target_idx)
             {
-                throw std::runtime_error("No points interpolated in IDW mode");
+                if (!kept[target_idx])
+                {
+                    continue;
+                }
+                if (out != target_idx)
+                {
+                    std::copy(result.values(target_idx), result.values(target_idx) + stride, result.values(out));
+                }
+                result.set_row(out++, target_points.longitude(target_idx), target_points.latitude(target_idx),
+                               target_points.time_step(target_idx));
             }
+
+            result.resize(out);
             return result;
         }
 
     private:
-        const std::vector<SpatialData> &source_points_;
+        const Field &source_;
         const RegridConfig &config_;
+        WarningSummary own_warnings_;
+        WarningSummary *warnings_;
     };
 
 } // namespace fastregrid
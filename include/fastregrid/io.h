@@ -14,7 +14,10 @@
 
 #include "config.h"
 #include "types.h"
+#include "grid_store.h"
+#include "memory.h"
 #include "utils.h"
+#include "logger.h"
 #include <fstream>
 #include <sstream>
 #include <iomanip>
@@ -23,6 +26,8 @@
 #include <string>
 #include <iostream>
 #include <algorithm>
+#include <tuple>
+#include <cerrno>
 
 #ifdef _WIN32
 #include <direct.h>
@@ -64,8 +69,11 @@ namespace fastregrid
             return headers;
         }
 
-        // Reads source or target gridpoints into a vector of SpatialData.
-        std::vector<SpatialData> read_grid() const
+        // Parses data rows in file order and calls fn(lon, lat, time_step, values, count)
+        // for each; values is reused between rows. Every row must have the same count.
+        // Returns the number of rows.
+        template <typename Fn>
+        size_t scan(Fn &&fn) const
         {
             std::ifstream file(filename_);
             if (!file.is_open())
@@ -73,7 +81,9 @@ namespace fastregrid
                 throw std::runtime_error("Cannot open input file: " + filename_);
             }
 
-            std::vector<SpatialData> points;
+            std::vector<ValueType> row_values;
+            size_t stride = 0;
+            size_t rows = 0;
             std::string line;
             std::getline(file, line); // Skip header
 
@@ -82,30 +92,20 @@ namespace fastregrid
             {
                 ++line_num;
                 std::istringstream iss(line);
-                SpatialData point;
-                if (!(iss >> point.gridPoint.longitude >> point.gridPoint.latitude >> point.time_step))
+                double lon, lat;
+                int time_step;
+                if (!parse_location(iss, line_num, lon, lat, time_step))
                 {
-                    if (config_.verbose)
-                    {
-                        std::cerr << "Warning: Skipping malformed line " << line_num << " in file: " << filename_ << std::endl;
-                    }
                     continue;
                 }
-                if (std::abs(point.gridPoint.latitude) > 90.0 || std::abs(point.gridPoint.longitude) > 360.0)
-                {
-                    throw std::runtime_error("Invalid coordinates at line " + std::to_string(line_num) + " in file: " + filename_);
-                }
-                if (config_.adjust_longitude)
-                {
-                    point.gridPoint.longitude = utils::adjust_longitude(point.gridPoint.longitude);
-                }
 
+                row_values.clear();
                 if (config_.data_layout == GRID_BY_TIME)
                 {
-                    point.values.resize(12); // Expect 12 monthly values
+                    row_values.resize(12); // Expect 12 monthly values
                     for (size_t i = 0; i < 12; ++i)
                     {
-                        if (!(iss >> point.values[i]))
+                        if (!(iss >> row_values[i]))
                         {
                             throw std::runtime_error("Missing monthly values at line " + std::to_string(line_num) + " in file: " + filename_);
                         }
@@ -113,12 +113,12 @@ namespace fastregrid
                 }
                 else if (config_.data_layout == YEAR_BY_YEAR)
                 {
-                    double value;
+                    ValueType value;
                     while (iss >> value)
                     {
-                        point.values.push_back(value);
+                        row_values.push_back(value);
                     }
-                    if (point.values.empty())
+                    if (row_values.empty())
                     {
                         throw std::runtime_error("No values found at line " + std::to_string(line_num) + " in file: " + filename_);
                     }
@@ -127,9 +127,65 @@ namespace fastregrid
                 {
                     throw std::runtime_error("Unknown data layout");
                 }
-                points.push_back(point);
+
+                if (rows == 0)
+                {
+                    stride = row_values.size();
+                }
+                else if (row_values.size() != stride)
+                {
+                    throw std::runtime_error("Inconsistent number of values at line " + std::to_string(line_num) + " in file: " + filename_);
+                }
+                fn(lon, lat, time_step, static_cast<const ValueType *>(row_values.data()), stride);
+                ++rows;
             }
             file.close();
+            return rows;
+        }
+
+        // Parses only the coordinates and time step of data rows, in file order, and
+        // calls fn(lon, lat, time_step) for each; values are neither parsed nor
+        // checked (scan() does that when they are read). Returns the number of rows.
+        template <typename Fn>
+        size_t scan_locations(Fn &&fn) const
+        {
+            std::ifstream file(filename_);
+            if (!file.is_open())
+            {
+                throw std::runtime_error("Cannot open input file: " + filename_);
+            }
+
+            size_t rows = 0;
+            std::string line;
+            std::getline(file, line); // Skip header
+
+            size_t line_num = 1;
+            while (std::getline(file, line))
+            {
+                ++line_num;
+                std::istringstream iss(line);
+                double lon, lat;
+                int time_step;
+                if (parse_location(iss, line_num, lon, lat, time_step))
+                {
+                    fn(lon, lat, time_step);
+                    ++rows;
+                }
+            }
+            return rows;
+        }
+
+        // Reads source or target gridpoints into a structure-of-arrays GridStore.
+        GridStore read_grid() const
+        {
+            GridStore points(0, buffer_policy(config_));
+            scan([&points](double lon, double lat, int time_step, const ValueType *values, size_t count)
+                 {
+                     if (points.empty())
+                     {
+                         points.set_stride(count);
+                     }
+                     points.push_back(lon, lat, time_step, values); });
             if (points.empty())
             {
                 throw std::runtime_error("Empty input file: " + filename_);
@@ -137,40 +193,69 @@ namespace fastregrid
             return points;
         }
 
-        // Writes unique coordinates to a gridlist file
-        void write_gridlist(const std::string &output_filename) const
+        // Reads only row coordinates and time steps (stride 0), setting stride to the
+        // number of values per row. Used when values are streamed separately.
+        GridStore read_locations(size_t &stride) const
         {
-            auto points = read_grid();
-            std::vector<std::pair<double, double>> unique_points;
-            for (const auto &point : points)
+            GridStore points(0, buffer_policy(config_));
+            stride = 0;
+            scan([&points, &stride](double lon, double lat, int time_step, const ValueType *values, size_t count)
+                 {
+                     stride = count;
+                     points.push_back(lon, lat, time_step, values); });
+            if (points.empty())
             {
-                unique_points.emplace_back(point.gridPoint.longitude, point.gridPoint.latitude);
+                throw std::runtime_error("Empty input file: " + filename_);
             }
-            // Sort and remove duplicates
-            std::sort(unique_points.begin(), unique_points.end());
-            unique_points.erase(std::unique(unique_points.begin(), unique_points.end()), unique_points.end());
+            return points;
+        }
 
-            std::ofstream file(config_.output_path + output_filename);
-            if (!file.is_open())
+    private:
+        // Reads the coordinates and time step that start a data row. Returns false
+        // for a malformed row, which is skipped; throws on invalid coordinates.
+        bool parse_location(std::istringstream &iss, size_t line_num, double &lon, double &lat, int &time_step) const
+        {
+            if (!(iss >> lon >> lat >> time_step))
             {
-                std::cerr << "Warning: Cannot open gridlist file: " + config_.output_path + output_filename << std::endl;
-                return;
+                if (config_.verbose)
+                {
+                    log_warning("Skipping malformed line {} in file: {}", line_num, filename_);
+                }
+                return false;
             }
-            file << "Lon\t Lat\n";
-            for (const auto &[lon, lat] : unique_points)
+            if (std::abs(lat) > 90.0 || std::abs(lon) > 360.0)
             {
-                file << std::fixed << std::setprecision(config_.precision)
-                     << std::setw(10) << lon
-                     << std::setw(10) << lat << '\n';
+                throw std::runtime_error("Invalid coordinates at line " + std::to_string(line_num) + " in file: " + filename_);
             }
-            file.close();
+            if (config_.adjust_longitude)
+            {
+                lon = utils::adjust_longitude(lon);
+            }
+            return true;
         }
 
-    private:
         std::string filename_; // check if we really this here? FIXME
         const RegridConfig &config_;
     };
 
+    // Checks that source and target headers describe compatible files for config.data_layout.
+    inline void validate_headers(const std::vector<std::string> &headers,
+                                 const std::vector<std::string> &target_headers, const RegridConfig &config)
+    {
+        if (headers.size() < 3 || target_headers.size() < 3)
+        {
+            throw std::runtime_error("Invalid headers in source or target file");
+        }
+        if (config.data_layout == GRID_BY_TIME && headers.size() != 15)
+        {
+            throw std::runtime_error("GRID_BY_TIME requires 12 monthly value columns plus Lon, Lat, Year");
+        }
+        if (headers.size() != target_headers.size())
+        {
+            throw std::runtime_error("Source and target files have different number of columns");
+        }
+    }
+
     class OutputWriter
     {
     public:
@@ -191,7 +276,7 @@ namespace fastregrid
         }
 
         // Writes regridded data with headers
-        void write_regridded_data(const std::vector<SpatialData> &points,
+        void write_regridded_data(const GridStore &points,
                                   const std::string &filename,
                                   const std::vector<std::string> &headers) const
         {
@@ -200,49 +285,102 @@ namespace fastregrid
             {
                 throw std::runtime_error("Cannot open output file: " + output_path_ + filename);
             }
+            write_headers(file, headers);
+            write_rows(file, points);
+            file.close();
+        }
 
-            // Write headers
-            for (size_t i = 0; i < headers.size(); ++i)
+        // Writes regridded data with headers, concatenating row files written by
+        // write_rows() (e.g. one per tile) in the given order.
+        void write_regridded_data(const std::vector<std::string> &row_files,
+                                  const std::string &filename,
+                                  const std::vector<std::string> &headers) const
+        {
+            std::ofstream file(output_path_ + filename, std::ios::binary);
+            if (!file.is_open())
             {
-                file << std::setw(i < 3 ? 10 : 12) << headers[i];
+                throw std::runtime_error("Cannot open output file: " + output_path_ + filename);
             }
-            file << '\n';
-
-            if (config_.data_layout == GRID_BY_TIME)
+            write_headers(file, headers);
+            for (const auto &row_file : row_files)
             {
-                for (const auto &point : points)
+                std::ifstream part(row_file, std::ios::binary);
+                if (!part.is_open())
                 {
-                    file << std::fixed << std::setprecision(config_.precision)
-                         << std::setw(10) << point.gridPoint.longitude
-                         << std::setw(10) << point.gridPoint.latitude
-                         << std::setw(10) << point.time_step;
-                    for (const auto &value : point.values)
-                    {
-                        file << std::setw(12) << value;
-                    }
-                    file << '\n';
+                    throw std::runtime_error("Cannot open output part: " + row_file);
+                }
+                if (part.peek() != std::ifstream::traits_type::eof())
+                {
+                    file << part.rdbuf();
                 }
             }
-            else if (config_.data_layout == YEAR_BY_YEAR)
+            file.close();
+        }
+
+        // Writes the header line of regridded data.
+        void write_headers(std::ostream &out, const std::vector<std::string> &headers) const
+        {
+            for (size_t i = 0; i < headers.size(); ++i)
+            {
+                out << std::setw(i < 3 ? 10 : 12) << headers[i];
+            }
+            out << '\n';
+        }
+
+        // Writes rows of regridded data (no header).
+        void write_rows(std::ostream &out, const GridStore &points) const
+        {
+            // GRID_BY_TIME and YEAR_BY_YEAR rows share one layout: Lon Lat Year Value1..ValueN
+            out << std::fixed << std::setprecision(config_.precision);
+            for (size_t i = 0; i < points.size(); ++i)
             {
-                for (const auto &point : points)
+                out << std::setw(10) << points.longitude(i)
+                    << std::setw(10) << points.latitude(i)
+                    << std::setw(10) << points.time_step(i);
+                const ValueType *values = points.values(i);
+                for (size_t j = 0; j < points.stride(); ++j)
                 {
-                    file << std::fixed << std::setprecision(config_.precision)
-                         << std::setw(10) << point.gridPoint.longitude
-                         << std::setw(10) << point.gridPoint.latitude
-                         << std::setw(10) << point.time_step;
-                    for (const auto &value : point.values)
-                    {
-                        file << std::setw(12) << value;
-                    }
-                    file << '\n';
+                    out << std::setw(12) << values[j];
                 }
+                out << '\n';
+            }
+        }
+
+        // Writes the given coordinates, sorted by longitude then latitude, to a
+        // gridlist file. Duplicates are not removed; callers pass the unique
+        // locations of a Grid.
+        void write_gridlist(const LargeVector<double> &longitudes,
+                            const LargeVector<double> &latitudes,
+                            const std::string &output_filename) const
+        {
+            std::vector<std::pair<double, double>> points;
+            points.reserve(longitudes.size());
+            for (size_t i = 0; i < longitudes.size(); ++i)
+            {
+                points.emplace_back(longitudes[i], latitudes[i]);
+            }
+            std::sort(points.begin(), points.end());
+
+            std::ofstream file(output_path_ + output_filename);
+            if (!file.is_open())
+            {
+                log_warning("Cannot open gridlist file: {}{}", output_path_, output_filename);
+                return;
+            }
+            file << "Lon\t Lat\n";
+            for (const auto &[lon, lat] : points)
+            {
+                file << std::fixed << std::setprecision(config_.precision)
+                     << std::setw(10) << lon
+                     << std::setw(10) << lat << '\n';
             }
             file.close();
         }
 
-        // Writes Nearest Neighbor mappings
-        void write_nn_mappings(const std::vector<std::tuple<double, double, double, double, double, size_t>> &mappings) const
+        // Writes Nearest Neighbor mappings. With row_locations, mappings are per
+        // target location and one block is written per target row.
+        void write_nn_mappings(const std::vector<NNMapping> &mappings,
+                               const std::vector<size_t> *row_locations = nullptr) const
         {
             if (!config_.write_mappings)
                 return;
@@ -251,25 +389,41 @@ namespace fastregrid
             {
                 throw std::runtime_error("Cannot open NN mappings file: " + output_path_ + config_.nn_mappings_file);
             }
+            write_nn_mapping_header(file);
+            write_nn_mapping_rows(file, mappings, row_locations);
+            file.close();
+        }
 
-            file << "Target_Lon Target_Lat Source_Lon Source_Lat Distance(km) Target_Index\n";
-            file << std::string(68, '-') << '\n';
-            for (const auto &[target_lon, target_lat, source_lon, source_lat, distance, target_idx] : mappings)
+        void write_nn_mapping_header(std::ostream &out) const
+        {
+            out << "Target_Lon Target_Lat Source_Lon Source_Lat Distance(km) Target_Index\n";
+            out << std::string(68, '-') << '\n';
+        }
+
+        // Writes NN mapping blocks; with row_locations, target rows are numbered from first_row.
+        void write_nn_mapping_rows(std::ostream &out, const std::vector<NNMapping> &mappings,
+                                   const std::vector<size_t> *row_locations, size_t first_row = 0) const
+        {
+            const size_t rows = row_locations ? row_locations->size() : mappings.size();
+            for (size_t row = 0; row < rows; ++row)
             {
-                file << std::fixed << std::setprecision(config_.precision)
-                     << std::setw(10) << target_lon
-                     << std::setw(10) << target_lat
-                     << std::setw(10) << source_lon
-                     << std::setw(10) << source_lat
-                     << std::setw(12) << distance
-                     << std::setw(12) << target_idx << '\n';
-                file << std::string(68, '-') << '\n';
+                const auto &[target_lon, target_lat, source_lon, source_lat, distance, target_idx, source_idx] =
+                    mappings.at(row_locations ? (*row_locations)[row] : row);
+                out << std::fixed << std::setprecision(config_.precision)
+                    << std::setw(10) << target_lon
+                    << std::setw(10) << target_lat
+                    << std::setw(10) << source_lon
+                    << std::setw(10) << source_lat
+                    << std::setw(12) << distance
+                    << std::setw(12) << (row_locations ? first_row + row : target_idx) << '\n';
+                out << std::string(68, '-') << '\n';
             }
-            file.close();
         }
 
-        // Writes IDW mappings
-        void write_idw_mappings(const std::vector<std::tuple<double, double, std::vector<std::tuple<double, double, double>>, size_t, bool>> &mappings) const
+        // Writes IDW mappings. With row_locations, mappings are per target
+        // location and one block is written per target row.
+        void write_idw_mappings(const std::vector<IDWMapping> &mappings,
+                                const std::vector<size_t> *row_locations = nullptr) const
         {
             if (!config_.write_mappings)
                 return;
@@ -278,27 +432,44 @@ namespace fastregrid
             {
                 throw std::runtime_error("Cannot open IDW mappings file: " + output_path_ + config_.idw_mappings_file);
             }
+            write_idw_mapping_header(file);
+            write_idw_mapping_rows(file, mappings, row_locations);
+            file.close();
+        }
+
+        void write_idw_mapping_header(std::ostream &out) const
+        {
+            out << "Target_Lon Target_Lat Source_Lon Source_Lat Distance(km) Target_Index Fallback\n";
+            out << std::string(80, '-') << '\n';
+        }
 
-            file << "Target_Lon Target_Lat Source_Lon Source_Lat Distance(km) Target_Index Fallback\n";
-            file << std::string(80, '-') << '\n';
-            for (const auto &[target_lon, target_lat, sources, target_idx, is_fallback] : mappings)
+        // Writes IDW mapping blocks; with row_locations, target rows are numbered from first_row.
+        void write_idw_mapping_rows(std::ostream &out, const std::vector<IDWMapping> &mappings,
+                                    const std::vector<size_t> *row_locations, size_t first_row = 0) const
+        {
+            const size_t rows = row_locations ? row_locations->size() : mappings.size();
+            for (size_t row = 0; row < rows; ++row)
             {
-                for (const auto &[source_lon, source_lat, distance] : sources)
+                const auto &[target_lon, target_lat, sources, target_idx, is_fallback] =
+                    mappings.at(row_locations ? (*row_locations)[row] : row);
+                for (const auto &[source_lon, source_lat, distance, source_idx] : sources)
                 {
-                    file << std::fixed << std::setprecision(config_.precision)
-                         << std::setw(10) << target_lon
-                         << std::setw(10) << target_lat
-                         << std::setw(10) << source_lon
-                         << std::setw(10) << source_lat
-                         << std::setw(12) << distance
-                         << std::setw(12) << target_idx
-                         << std::setw(8) << (is_fallback ? "NN" : "") << '\n';
+                    out << std::fixed << std::setprecision(config_.precision)
+                        << std::setw(10) << target_lon
+                        << std::setw(10) << target_lat
+                        << std::setw(10) << source_lon
+                        << std::setw(10) << source_lat
+                        << std::setw(12) << distance
+                        << std::setw(12) << (row_locations ? first_row + row : target_idx)
+                        << std::setw(8) << (is_fallback ? "NN" : "") << '\n';
                 }
-                file << std::string(80, '-') << '\n';
+                out << std::string(80, '-') << '\n';
             }
-            file.close();
         }
 
+        // Full path of an output file name.
+        std::string path(const std::string &filename) const { return output_path_ + filename; }
+
     private:
         const RegridConfig &config_;
         std::string output_path_;
@@ -11,17 +11,41 @@
 
 #pragma once
 
+#include <atomic>
+#include <algorithm>
 #include <chrono>
-#include <iomanip>
-#include <iostream>
-#include <sstream>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <cerrno>
 #include <fstream>
-#include <stdexcept>
-#include "filesystem.h"
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <sys/stat.h>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <direct.h> // For _mkdir
+#endif
 
 namespace fastregrid
 {
 
+    // Asynchronous logger. A call on the hot path only checks the level and
+    // copies a compact record (timestamp, format pointer, arguments) into a
+    // lock-free ring owned by the calling thread; a background thread drains
+    // the rings, formats the records in time order and writes them. Records
+    // that find their ring full are dropped and counted, never waited for.
+    //
+    // DEBUG and INFO go to std::cout, WARN and ERROR to std::cerr, and every
+    // record to the log file once initialize() has opened one.
     class FastRegridLogger
     {
     public:
@@ -33,11 +57,96 @@ namespace fastregrid
             ERROR
         };
 
-        static FastRegridLogger &getInstance();
+        static FastRegridLogger &getInstance()
+        {
+            static FastRegridLogger instance;
+            return instance;
+        }
+
+        // Opens logs/fastregrid_<time>.log under baseDir and sets the minimum level.
+        void initialize(const std::string &baseDir = "./", LogLevel minLevel = LogLevel::INFO)
+        {
+            std::string logDir = baseDir;
+            if (!logDir.empty() && logDir.back() != '/' && logDir.back() != '\\')
+            {
+                logDir += '/';
+            }
+            logDir += "logs";
+#if defined(_WIN32) || defined(_WIN64)
+            const bool created = _mkdir(logDir.c_str()) == 0 || errno == EEXIST;
+#else
+            const bool created = (mkdir)(logDir.c_str(), 0755) == 0 || errno == EEXIST; // Not io.h's mkdir macro
+#endif
+            if (!created)
+            {
+                std::cerr << "[ERROR] Failed to create log directory: " << logDir << "\n";
+                return;
+            }
 
-        void initialize(const std::string &baseDir = "./", LogLevel minLevel = LogLevel::INFO);
+            const std::string logFilePath =
+                logDir + "/fastregrid_" + formatTime(std::chrono::system_clock::now(), "%Y%m%d_%H%M%S") + ".log";
+            {
+                std::lock_guard<std::mutex> lock(sinkMutex_);
+                if (logFile_.is_open())
+                {
+                    logFile_.close();
+                }
+                logFile_.open(logFilePath, std::ios::out | std::ios::app);
+                if (!logFile_.is_open())
+                {
+                    std::cerr << "[ERROR] Failed to open log file: " << logFilePath << "\n";
+                    return;
+                }
+            }
 
-        void log(LogLevel level, const std::string &message, const std::string &details = "");
+            setMinLevel(minLevel);
+            log(LogLevel::INFO, "FastRegrid Logger initialized", "Log file: " + logFilePath);
+        }
+
+        // Logs message, followed by " [details]" if details are given.
+        void log(LogLevel level, const std::string &message, const std::string &details = "")
+        {
+            if (!enabled(level))
+            {
+                return;
+            }
+            Ring &ring = localRing();
+            Record *record = ring.claim(level);
+            if (!record)
+            {
+                return;
+            }
+            appendText(*record, message.data(), message.size());
+            if (!details.empty())
+            {
+                appendText(*record, " [", 2);
+                appendText(*record, details.data(), details.size());
+                appendText(*record, "]", 1);
+            }
+            publish(ring, level);
+        }
+
+        // Logs format (a string literal) with each "{}" replaced by the next
+        // argument. Arguments may be numbers or strings; strings are copied,
+        // numbers are formatted by the background thread.
+        template <typename... Args>
+        void emit(LogLevel level, const char *format, const Args &...args)
+        {
+            static_assert(sizeof...(Args) <= MAX_ARGS, "Too many log arguments");
+            if (!enabled(level))
+            {
+                return;
+            }
+            Ring &ring = localRing();
+            Record *record = ring.claim(level);
+            if (!record)
+            {
+                return;
+            }
+            record->format = format;
+            (addArg(*record, args), ...);
+            publish(ring, level);
+        }
 
         void debug(const std::string &message, const std::string &details = "")
         {
@@ -56,148 +165,374 @@ namespace fastregrid
             log(LogLevel::ERROR, message, details);
         }
 
-        void setMinLevel(LogLevel level);
+        void setMinLevel(LogLevel level)
+        {
+            minLevel_.store(level, std::memory_order_relaxed);
+        }
+
+        bool enabled(LogLevel level) const
+        {
+            return level >= minLevel_.load(std::memory_order_relaxed);
+        }
+
+        // Returns once every record logged before the call has been written.
+        void flush()
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            const uint64_t target = passes_ + 2; // A whole pass that started after this call
+            flushRequested_ = true;
+            wake_.notify_all();
+            flushed_.wait(lock, [&]()
+                          { return passes_ >= target || stop_; });
+        }
 
     private:
-        FastRegridLogger() = default;
-        ~FastRegridLogger();
+        static constexpr size_t MAX_ARGS = 8;
+        static constexpr size_t TEXT_BYTES = 256;
+        static constexpr size_t RING_CAPACITY = 1024; // Records per thread, a power of two
 
-        FastRegridLogger(const FastRegridLogger &) = delete;
-        FastRegridLogger &operator=(const FastRegridLogger &) = delete;
+        struct Arg
+        {
+            enum Kind : uint8_t
+            {
+                INT,
+                UINT,
+                FLOAT,
+                TEXT
+            } kind;
+            union
+            {
+                long long i;
+                unsigned long long u;
+                double d;
+                uint32_t text[2]; // Offset and length in Record::text
+            };
+        };
 
-        std::string getTimestamp() const;
-        std::string levelToString(LogLevel level) const;
+        struct Record
+        {
+            int64_t time = 0;              // Nanoseconds since the epoch (system clock)
+            const char *format = nullptr;  // Static format, or null when text is the message
+            LogLevel level = LogLevel::INFO;
+            uint8_t argCount = 0;
+            uint16_t textSize = 0;
+            Arg args[MAX_ARGS];
+            char text[TEXT_BYTES];
+        };
 
-        std::ofstream logFile_;
-        LogLevel minLevel_ = LogLevel::INFO;
-        bool initialized_ = false;
-    };
+        // Single-producer (the owning thread), single-consumer (the writer) ring.
+        struct Ring
+        {
+            Record slots[RING_CAPACITY];
+            alignas(64) std::atomic<size_t> head{0};
+            alignas(64) std::atomic<size_t> tail{0};
+            std::atomic<size_t> dropped{0};
+            std::atomic<bool> retired{false}; // Owning thread has exited
 
-    FastRegridLogger &FastRegridLogger::getInstance()
-    {
-        static FastRegridLogger instance;
-        return instance;
-    }
+            // Next free slot, timestamped and cleared, or null (counted) if full.
+            Record *claim(LogLevel level)
+            {
+                const size_t index = tail.load(std::memory_order_relaxed);
+                if (index - head.load(std::memory_order_acquire) == RING_CAPACITY)
+                {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return nullptr;
+                }
+                Record &record = slots[index % RING_CAPACITY];
+                record.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                  std::chrono::system_clock::now().time_since_epoch())
+                                  .count();
+                record.format = nullptr;
+                record.level = level;
+                record.argCount = 0;
+                record.textSize = 0;
+                return &record;
+            }
+        };
 
-    void FastRegridLogger::initialize(const std::string &baseDir, LogLevel minLevel)
-    {
-        if (initialized_)
+        // Per-thread handle; marks the ring retired when its thread exits.
+        struct Producer
+        {
+            std::shared_ptr<Ring> ring;
+            ~Producer()
+            {
+                if (ring)
+                {
+                    ring->retired.store(true, std::memory_order_release);
+                }
+            }
+        };
+
+        FastRegridLogger() : writer_([this]()
+                                     { run(); })
         {
-            logFile_.close();
         }
 
-        filesystem::path logDir = filesystem::path(baseDir) / "logs";
-        if (!filesystem::create_directory(logDir.string()))
+        ~FastRegridLogger()
         {
-            std::cerr << "[ERROR] Failed to create log directory: " << logDir.string() << "\n";
-            return;
+            {
+                std::lock_guard<std::mutex> lock(wakeMutex_);
+                stop_ = true;
+            }
+            wake_.notify_all();
+            writer_.join();
         }
 
-        auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
-        std::stringstream ss;
-        ss << std::put_time(std::localtime(&time_t), "%Y%m%d_%H%M%S");
-        std::string timestamp = ss.str();
-        filesystem::path logFilePath = logDir / ("fastregrid_" + timestamp + ".log");
+        FastRegridLogger(const FastRegridLogger &) = delete;
+        FastRegridLogger &operator=(const FastRegridLogger &) = delete;
 
-        logFile_.open(logFilePath.string(), std::ios::out | std::ios::app);
-        if (!logFile_.is_open())
+        static void appendText(Record &record, const char *text, size_t size)
         {
-            std::cerr << "[ERROR] Failed to open log file: " << logFilePath.string() << "\n";
-            return;
+            size = std::min(size, TEXT_BYTES - record.textSize);
+            std::memcpy(record.text + record.textSize, text, size);
+            record.textSize = static_cast<uint16_t>(record.textSize + size);
         }
 
-        minLevel_ = minLevel;
-        initialized_ = true;
-
-        log(LogLevel::INFO, "FastRegrid Logger initialized", "Log file: " + logFilePath.string());
-    }
+        template <typename T>
+        static void addArg(Record &record, const T &value)
+        {
+            Arg &arg = record.args[record.argCount++];
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                arg.kind = Arg::FLOAT;
+                arg.d = static_cast<double>(value);
+            }
+            else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+            {
+                arg.kind = Arg::INT;
+                arg.i = static_cast<long long>(value);
+            }
+            else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>)
+            {
+                arg.kind = Arg::UINT;
+                arg.u = static_cast<unsigned long long>(value);
+            }
+            else
+            {
+                const std::string_view text(value);
+                arg.kind = Arg::TEXT;
+                arg.text[0] = record.textSize;
+                appendText(record, text.data(), text.size());
+                arg.text[1] = record.textSize - arg.text[0];
+            }
+        }
 
-    void FastRegridLogger::log(LogLevel level, const std::string &message, const std::string &details)
-    {
-        if (!initialized_ || level < minLevel_)
+        // Makes the claimed record visible to the writer, waking it early for
+        // errors and when the ring is half full.
+        void publish(Ring &ring, LogLevel level)
         {
-            return;
+            const size_t tail = ring.tail.load(std::memory_order_relaxed) + 1;
+            ring.tail.store(tail, std::memory_order_release);
+            if (level == LogLevel::ERROR || tail - ring.head.load(std::memory_order_relaxed) == RING_CAPACITY / 2)
+            {
+                wake_.notify_one();
+            }
         }
 
-        std::string timestamp = getTimestamp();
-        std::string levelStr = levelToString(level);
-        std::string prefix = (level == LogLevel::WARN) ? "[WARNING]" : (level == LogLevel::ERROR) ? "[ERROR]"
-                                                                                                  : "[" + levelStr + "]";
-        std::string logMessage = "[FastRegrid][" + timestamp + "] " + prefix + " " + message;
-        if (!details.empty())
+        Ring &localRing()
         {
-            logMessage += " [" + details + "]";
+            thread_local Producer producer;
+            if (!producer.ring)
+            {
+                producer.ring = std::make_shared<Ring>();
+                std::lock_guard<std::mutex> lock(ringsMutex_);
+                rings_.push_back(producer.ring);
+            }
+            return *producer.ring;
         }
 
-        // Output destinations based on log level
-        if (level == LogLevel::DEBUG)
+        // Background thread: drains all rings every millisecond while records
+        // arrive (every 20 when idle, or when woken), writes their records in
+        // time order and drops the rings of exited threads.
+        void run()
         {
-            // DEBUG: File-only unless minLevel_ is DEBUG
-            if (minLevel_ == LogLevel::DEBUG && level == LogLevel::DEBUG)
+            std::vector<Record> batch;
+            std::string line;
+            bool idle = true;
+            for (;;)
             {
-                std::cout << logMessage << std::endl;
+                bool stopping;
+                {
+                    std::unique_lock<std::mutex> lock(wakeMutex_);
+                    wake_.wait_for(lock, std::chrono::milliseconds(idle ? 20 : 1), [this]()
+                                   { return stop_ || flushRequested_; });
+                    stopping = stop_;
+                    flushRequested_ = false;
+                }
+
+                std::vector<std::shared_ptr<Ring>> rings;
+                {
+                    std::lock_guard<std::mutex> lock(ringsMutex_);
+                    rings = rings_;
+                }
+                size_t dropped = 0;
+                for (auto &ring : rings)
+                {
+                    const bool retired = ring->retired.load(std::memory_order_acquire);
+                    size_t head = ring->head.load(std::memory_order_relaxed);
+                    const size_t tail = ring->tail.load(std::memory_order_acquire);
+                    for (; head != tail; ++head)
+                    {
+                        batch.push_back(ring->slots[head % RING_CAPACITY]);
+                    }
+                    ring->head.store(head, std::memory_order_release);
+                    dropped += ring->dropped.exchange(0, std::memory_order_relaxed);
+                    if (retired)
+                    {
+                        std::lock_guard<std::mutex> lock(ringsMutex_);
+                        rings_.erase(std::remove(rings_.begin(), rings_.end(), ring), rings_.end());
+                    }
+                }
+
+                std::stable_sort(batch.begin(), batch.end(), [](const Record &a, const Record &b)
+                                 { return a.time < b.time; });
+                {
+                    std::lock_guard<std::mutex> lock(sinkMutex_);
+                    for (const auto &record : batch)
+                    {
+                        format(record, line);
+                        write(record.level, line);
+                    }
+                    if (dropped != 0)
+                    {
+                        Record note;
+                        note.level = LogLevel::WARN;
+                        note.time = batch.empty() ? 0 : batch.back().time;
+                        const std::string text = std::to_string(dropped) + " log records dropped (logging faster than output)";
+                        appendText(note, text.data(), text.size());
+                        format(note, line);
+                        write(note.level, line);
+                    }
+                    if (!batch.empty() || dropped != 0)
+                    {
+                        std::cout.flush();
+                        std::cerr.flush();
+                        if (logFile_.is_open())
+                        {
+                            logFile_.flush();
+                        }
+                    }
+                }
+                idle = batch.empty();
+                batch.clear();
+
+                {
+                    std::lock_guard<std::mutex> lock(wakeMutex_);
+                    ++passes_;
+                }
+                flushed_.notify_all();
+                if (stopping)
+                {
+                    return;
+                }
             }
         }
-        else if (level == LogLevel::ERROR)
+
+        void format(const Record &record, std::string &line) const
         {
-            // ERROR: Console (cerr), file
-            std::cerr << logMessage << std::endl;
-            std::cout << logMessage << std::endl;
+            const auto time = std::chrono::system_clock::time_point(
+                std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(record.time)));
+            line = "[FastRegrid][" + formatTime(time, "%Y-%m-%d %H:%M:%S") + "] " + levelToString(record.level) + " ";
+            if (!record.format)
+            {
+                line.append(record.text, record.textSize);
+                return;
+            }
+            size_t next = 0;
+            for (const char *p = record.format; *p; ++p)
+            {
+                if (p[0] == '{' && p[1] == '}' && next < record.argCount)
+                {
+                    appendArg(record, record.args[next++], line);
+                    ++p;
+                }
+                else
+                {
+                    line += *p;
+                }
+            }
         }
-        else
+
+        static void appendArg(const Record &record, const Arg &arg, std::string &line)
         {
-            // INFO, WARN: Console (cout), file
-            std::cout << logMessage << std::endl;
+            char buffer[32];
+            switch (arg.kind)
+            {
+            case Arg::INT:
+                std::snprintf(buffer, sizeof(buffer), "%lld", arg.i);
+                break;
+            case Arg::UINT:
+                std::snprintf(buffer, sizeof(buffer), "%llu", arg.u);
+                break;
+            case Arg::FLOAT:
+                std::snprintf(buffer, sizeof(buffer), "%g", arg.d); // As std::ostream by default
+                break;
+            case Arg::TEXT:
+                line.append(record.text + arg.text[0], arg.text[1]);
+                return;
+            }
+            line += buffer;
         }
 
-        if (logFile_.is_open())
+        void write(LogLevel level, const std::string &line)
         {
-            logFile_ << logMessage << std::endl;
-            if (level == LogLevel::ERROR)
+            std::ostream &console = level >= LogLevel::WARN ? std::cerr : std::cout;
+            console << line << '\n';
+            if (logFile_.is_open())
             {
-                logFile_.flush(); // Immediate flush for errors
+                logFile_ << line << '\n';
             }
         }
-    }
 
-    void FastRegridLogger::setMinLevel(LogLevel level)
-    {
-        minLevel_ = level;
-    }
+        static std::string formatTime(std::chrono::system_clock::time_point time, const char *pattern)
+        {
+            const std::time_t seconds = std::chrono::system_clock::to_time_t(time);
+            std::tm local{};
+#if defined(_WIN32) || defined(_WIN64)
+            localtime_s(&local, &seconds);
+#else
+            localtime_r(&seconds, &local);
+#endif
+            char buffer[64];
+            return std::string(buffer, std::strftime(buffer, sizeof(buffer), pattern, &local));
+        }
 
-    FastRegridLogger::~FastRegridLogger()
-    {
-        if (logFile_.is_open())
+        static const char *levelToString(LogLevel level)
         {
-            logFile_.close();
+            switch (level)
+            {
+            case LogLevel::DEBUG:
+                return "[DEBUG]";
+            case LogLevel::INFO:
+                return "[INFO]";
+            case LogLevel::WARN:
+                return "[WARNING]";
+            case LogLevel::ERROR:
+                return "[ERROR]";
+            default:
+                return "[UNKNOWN]";
+            }
         }
-    }
 
-    std::string FastRegridLogger::getTimestamp() const
-    {
-        auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
-        std::stringstream ss;
-        ss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
-        return ss.str();
-    }
+        std::atomic<LogLevel> minLevel_{LogLevel::INFO};
+        std::mutex ringsMutex_;
+        std::vector<std::shared_ptr<Ring>> rings_;
+        std::mutex sinkMutex_;
+        std::ofstream logFile_;
+        std::mutex wakeMutex_;
+        std::condition_variable wake_;
+        std::condition_variable flushed_;
+        uint64_t passes_ = 0;
+        bool flushRequested_ = false;
+        bool stop_ = false;
+        std::thread writer_; // Last: started once everything above is constructed
+    };
 
-    std::string FastRegridLogger::levelToString(LogLevel level) const
+    // Logs a library warning ("{}" placeholders, see FastRegridLogger::emit).
+    template <typename... Args>
+    void log_warning(const char *format, const Args &...args)
     {
-        switch (level)
-        {
-        case LogLevel::DEBUG:
-            return "DEBUG";
-        case LogLevel::INFO:
-            return "INFO";
-        case LogLevel::WARN:
-            return "WARN";
-        case LogLevel::ERROR:
-            return "ERROR";
-        default:
-            return "UNKNOWN";
-        }
+        FastRegridLogger::getInstance().emit(FastRegridLogger::LogLevel::WARN, format, args...);
     }
 
-} // namespace fastregrid
\ No newline at end of file
+} // namespace fastregrid
@@ -0,0 +1,375 @@
+/*
+ * memory.h
+ * Huge-page and NUMA-aware allocation for large grid buffers in FastRegrid.
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#ifndef FASTREGRID_MEMORY_H
+#define FASTREGRID_MEMORY_H
+
+#include "config.h"
+#include "types.h"
+#include "thread_pool.h"
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <stdexcept>
+#include <fstream>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#endif
+
+namespace fastregrid
+{
+
+    // Placement of large buffers across NUMA nodes.
+    struct LargeBufferPolicy
+    {
+        bool huge_pages = false;                   // madvise(MADV_HUGEPAGE) on large buffers
+        NumaPlacement numa_placement = NUMA_LOCAL; // First-touch (local) or interleaved across nodes
+    };
+
+    inline LargeBufferPolicy buffer_policy(const RegridConfig &config)
+    {
+        LargeBufferPolicy policy;
+        policy.huge_pages = config.huge_pages;
+        policy.numa_placement = config.numa_placement;
+        return policy;
+    }
+
+    namespace memory
+    {
+
+        // Allocations at or above this size are mapped directly (one 2 MiB huge page).
+        constexpr size_t LARGE_BUFFER_THRESHOLD = size_t(2) << 20;
+
+        inline size_t round_up(size_t bytes, size_t alignment)
+        {
+            return (bytes + alignment - 1) / alignment * alignment;
+        }
+
+#ifdef __linux__
+        // Interleaves pages of [addr, addr + bytes) over all NUMA nodes this process may use.
+        inline void interleave_pages(void *addr, size_t bytes)
+        {
+            constexpr unsigned long MAX_NODES = 1024;
+            unsigned long nodemask[MAX_NODES / (8 * sizeof(unsigned long))] = {};
+            int mode = 0;
+            if (syscall(SYS_get_mempolicy, &mode, nodemask, MAX_NODES, nullptr, MPOL_F_MEMS_ALLOWED) != 0)
+            {
+                return; // No NUMA support; default placement is fine
+            }
+            syscall(SYS_mbind, addr, bytes, MPOL_INTERLEAVE, nodemask, MAX_NODES, 0);
+        }
+#endif
+
+        // Allocates bytes; large requests are 2 MiB-aligned anonymous mappings so
+        // that transparent huge pages and NUMA policies apply to whole pages.
+        // Pages are not touched here, so the first writer decides local placement.
+        inline void *allocate(size_t bytes, const LargeBufferPolicy &policy)
+        {
+#ifdef __linux__
+            if (bytes >= LARGE_BUFFER_THRESHOLD)
+            {
+                size_t length = round_up(bytes, LARGE_BUFFER_THRESHOLD);
+                // Over-map by one huge page and trim, to get 2 MiB alignment.
+                size_t mapped = length + LARGE_BUFFER_THRESHOLD;
+                void *raw = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (raw == MAP_FAILED)
+                {
+                    throw std::bad_alloc();
+                }
+                uintptr_t begin = reinterpret_cast<uintptr_t>(raw);
+                uintptr_t aligned = round_up(begin, LARGE_BUFFER_THRESHOLD);
+                if (aligned > begin)
+                {
+                    munmap(raw, aligned - begin);
+                }
+                size_t tail = (begin + mapped) - (aligned + length);
+                if (tail > 0)
+                {
+                    munmap(reinterpret_cast<void *>(aligned + length), tail);
+                }
+                void *addr = reinterpret_cast<void *>(aligned);
+                if (policy.huge_pages)
+                {
+                    madvise(addr, length, MADV_HUGEPAGE); // Advisory; ignore failure
+                }
+                if (policy.numa_placement == NUMA_INTERLEAVED)
+                {
+                    interleave_pages(addr, length);
+                }
+                return addr;
+            }
+#else
+            (void)policy;
+#endif
+            return ::operator new(bytes);
+        }
+
+        // Releases memory from allocate(); bytes must match the requested size.
+        inline void deallocate(void *addr, size_t bytes)
+        {
+#ifdef __linux__
+            if (bytes >= LARGE_BUFFER_THRESHOLD)
+            {
+                munmap(addr, round_up(bytes, LARGE_BUFFER_THRESHOLD));
+                return;
+            }
+#endif
+            ::operator delete(addr);
+        }
+
+        // Zero-fills data on pool (serially if null) in one contiguous partition
+        // per worker, so that with local placement each page lands on the node of
+        // the worker that later processes the same partition.
+        template <typename T>
+        void first_touch(T *data, size_t count, ThreadPool *pool)
+        {
+            const size_t partitions = pool ? std::max<size_t>(1, std::min(pool->size(), count / 4096 + 1)) : 1;
+            if (partitions == 1)
+            {
+                std::fill(data, data + count, T());
+                return;
+            }
+            pool->parallel_for(0, count, (count + partitions - 1) / partitions, [data](size_t begin, size_t end)
+                               { std::fill(data + begin, data + end, T()); });
+        }
+
+        // Read/write mapping of an anonymous temporary file, used to spill
+        // buffers that exceed the memory budget. The file is unlinked as soon as
+        // it is created, so it disappears when the mapping is released (or the
+        // process exits); the kernel pages it in and out on demand.
+        class SpillFile
+        {
+        public:
+            SpillFile() = default;
+
+            SpillFile(size_t bytes, std::string directory)
+            {
+#ifdef __linux__
+                if (directory.empty())
+                {
+                    const char *tmpdir = std::getenv("TMPDIR");
+                    directory = tmpdir && *tmpdir ? tmpdir : "/tmp";
+                }
+                if (directory.back() != '/')
+                {
+                    directory += '/';
+                }
+                std::string path = directory + "fastregrid_spill_XXXXXX";
+                int fd = mkstemp(&path[0]);
+                if (fd < 0)
+                {
+                    throw std::runtime_error("Cannot create spill file in: " + directory);
+                }
+                unlink(path.c_str());
+                size_ = std::max<size_t>(bytes, 1);
+                if (ftruncate(fd, static_cast<off_t>(size_)) != 0)
+                {
+                    close(fd);
+                    throw std::runtime_error("Cannot size spill file in: " + directory);
+                }
+                void *addr = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                close(fd); // The mapping keeps the file alive
+                if (addr == MAP_FAILED)
+                {
+                    throw std::runtime_error("Cannot map spill file in: " + directory);
+                }
+                data_ = addr;
+#else
+                (void)bytes;
+                (void)directory;
+                throw std::runtime_error("Spilling to disk is only supported on Linux");
+#endif
+            }
+
+            SpillFile(const SpillFile &) = delete;
+            SpillFile &operator=(const SpillFile &) = delete;
+
+            SpillFile(SpillFile &&other) noexcept
+                : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+
+            SpillFile &operator=(SpillFile &&other) noexcept
+            {
+                if (this != &other)
+                {
+                    release();
+                    data_ = std::exchange(other.data_, nullptr);
+                    size_ = std::exchange(other.size_, 0);
+                }
+                return *this;
+            }
+
+            ~SpillFile() { release(); }
+
+            void *data() const { return data_; }
+            size_t size() const { return size_; }
+
+        private:
+            void release()
+            {
+#ifdef __linux__
+                if (data_)
+                {
+                    munmap(data_, size_);
+                }
+#endif
+                data_ = nullptr;
+                size_ = 0;
+            }
+
+            void *data_ = nullptr;
+            size_t size_ = 0;
+        };
+
+        // Read-only shared mapping of an existing file, so that processes reading
+        // the same file share its pages. Elsewhere than Linux the file is read
+        // into memory instead.
+        class MappedFile
+        {
+        public:
+            MappedFile() = default;
+
+            explicit MappedFile(const std::string &filename)
+            {
+#ifdef __linux__
+                int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd < 0)
+                {
+                    throw std::runtime_error("Cannot open file: " + filename);
+                }
+                struct stat info;
+                if (fstat(fd, &info) != 0)
+                {
+                    close(fd);
+                    throw std::runtime_error("Cannot stat file: " + filename);
+                }
+                size_ = static_cast<size_t>(info.st_size);
+                if (size_ > 0)
+                {
+                    void *addr = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+                    if (addr == MAP_FAILED)
+                    {
+                        close(fd);
+                        throw std::runtime_error("Cannot map file: " + filename);
+                    }
+                    data_ = addr;
+                }
+                close(fd);
+#else
+                std::ifstream file(filename, std::ios::binary | std::ios::ate);
+                if (!file.is_open())
+                {
+                    throw std::runtime_error("Cannot open file: " + filename);
+                }
+                size_ = static_cast<size_t>(file.tellg());
+                buffer_.resize((size_ + sizeof(uint64_t) - 1) / sizeof(uint64_t)); // 8-byte aligned
+                file.seekg(0);
+                if (!file.read(reinterpret_cast<char *>(buffer_.data()), static_cast<std::streamsize>(size_)))
+                {
+                    throw std::runtime_error("Cannot read file: " + filename);
+                }
+                data_ = buffer_.data();
+#endif
+            }
+
+            MappedFile(const MappedFile &) = delete;
+            MappedFile &operator=(const MappedFile &) = delete;
+
+            ~MappedFile()
+            {
+#ifdef __linux__
+                if (data_)
+                {
+                    munmap(data_, size_);
+                }
+#endif
+            }
+
+            const void *data() const { return data_; }
+            size_t size() const { return size_; }
+
+        private:
+            void *data_ = nullptr;
+            size_t size_ = 0;
+#ifndef __linux__
+            std::vector<uint64_t> buffer_;
+#endif
+        };
+
+    } // namespace memory
+
+    // Standard allocator for large, long-lived buffers (source values, weights,
+    // coordinate arrays). Small requests fall through to operator new.
+    template <typename T>
+    class LargeBufferAllocator
+    {
+    public:
+        using value_type = T;
+
+        LargeBufferAllocator() = default;
+        explicit LargeBufferAllocator(const LargeBufferPolicy &policy) : policy_(policy) {}
+
+        template <typename U>
+        LargeBufferAllocator(const LargeBufferAllocator<U> &other) : policy_(other.policy()) {}
+
+        T *allocate(size_t n)
+        {
+            return static_cast<T *>(memory::allocate(n * sizeof(T), policy_));
+        }
+
+        void deallocate(T *p, size_t n)
+        {
+            memory::deallocate(p, n * sizeof(T));
+        }
+
+        // Default construction leaves trivial values uninitialized, so that
+        // resize() does not touch pages before memory::first_touch does.
+        template <typename U>
+        void construct(U *p) noexcept(std::is_nothrow_default_constructible<U>::value)
+        {
+            ::new (static_cast<void *>(p)) U;
+        }
+        template <typename U, typename... Args>
+        void construct(U *p, Args &&...args)
+        {
+            ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...);
+        }
+
+        const LargeBufferPolicy &policy() const { return policy_; }
+
+        // Any instance can free memory from any other: the release path depends only on size.
+        template <typename U>
+        bool operator==(const LargeBufferAllocator<U> &) const { return true; }
+        template <typename U>
+        bool operator!=(const LargeBufferAllocator<U> &) const { return false; }
+
+    private:
+        LargeBufferPolicy policy_;
+    };
+
+    template <typename T>
+    using LargeVector = std::vector<T, LargeBufferAllocator<T>>;
+
+} // namespace fastregrid
+
+#endif // FASTREGRID_MEMORY_H
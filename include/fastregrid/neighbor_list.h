@@ -0,0 +1,158 @@
+/*
+ * neighbor_list.h
+ * Bounded nearest-candidate lists used by the IDW neighbour search in FastRegrid.
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#ifndef FASTREGRID_NEIGHBOR_LIST_H
+#define FASTREGRID_NEIGHBOR_LIST_H
+
+#include "types.h"
+#include <array>
+#include <vector>
+#include <stdexcept>
+#include <string>
+#include <cstddef>
+
+namespace fastregrid
+{
+
+    // Keeps the `limit` nearest candidates offered so far, sorted by distance.
+    // Storage is an inline array, so offering candidates never allocates.
+    // Ties keep the earlier candidate first.
+    template <size_t Capacity>
+    class InlineNeighborList
+    {
+    public:
+        static constexpr size_t capacity = Capacity;
+
+        explicit InlineNeighborList(size_t limit) : limit_(limit)
+        {
+            if (limit_ == 0 || limit_ > Capacity)
+            {
+                throw std::invalid_argument("Neighbor list limit must be in [1, " + std::to_string(Capacity) + "]");
+            }
+        }
+
+        void clear()
+        {
+            size_ = 0;
+            offered_ = 0;
+        }
+
+        void offer(double lon, double lat, double distance, size_t source_index)
+        {
+            ++offered_;
+            if (size_ == limit_ && !(distance < std::get<2>(items_[size_ - 1])))
+            {
+                return;
+            }
+            size_t pos = size_ < limit_ ? size_++ : size_ - 1;
+            while (pos > 0 && distance < std::get<2>(items_[pos - 1]))
+            {
+                items_[pos] = items_[pos - 1];
+                --pos;
+            }
+            items_[pos] = IDWNeighbor(lon, lat, distance, source_index);
+        }
+
+        size_t size() const { return size_; }
+        size_t offered() const { return offered_; } // All candidates seen, including dropped ones
+        const IDWNeighbor *begin() const { return items_.data(); }
+        const IDWNeighbor *end() const { return items_.data() + size_; }
+
+    private:
+        std::array<IDWNeighbor, Capacity> items_;
+        size_t limit_;
+        size_t size_ = 0;
+        size_t offered_ = 0;
+    };
+
+    // Generic fallback for limits above the inline instantiations. Uses one
+    // heap buffer reserved up front and reused across targets.
+    class DynamicNeighborList
+    {
+    public:
+        explicit DynamicNeighborList(size_t limit) : limit_(limit)
+        {
+            if (limit_ == 0)
+            {
+                throw std::invalid_argument("Neighbor list limit must be positive");
+            }
+            items_.reserve(limit_);
+        }
+
+        void clear()
+        {
+            items_.clear();
+            offered_ = 0;
+        }
+
+        void offer(double lon, double lat, double distance, size_t source_index)
+        {
+            ++offered_;
+            if (items_.size() == limit_ && !(distance < std::get<2>(items_.back())))
+            {
+                return;
+            }
+            if (items_.size() < limit_)
+            {
+                items_.emplace_back();
+            }
+            size_t pos = items_.size() - 1;
+            while (pos > 0 && distance < std::get<2>(items_[pos - 1]))
+            {
+                items_[pos] = items_[pos - 1];
+                --pos;
+            }
+            items_[pos] = IDWNeighbor(lon, lat, distance, source_index);
+        }
+
+        size_t size() const { return items_.size(); }
+        size_t offered() const { return offered_; }
+        const IDWNeighbor *begin() const { return items_.data(); }
+        const IDWNeighbor *end() const { return items_.data() + items_.size(); }
+
+    private:
+        std::vector<IDWNeighbor> items_;
+        size_t limit_;
+        size_t offered_ = 0;
+    };
+
+    // Calls fn with the smallest neighbour list type able to hold max_points:
+    // InlineNeighborList<4/8/16>, or DynamicNeighborList above 16.
+    template <typename Fn>
+    decltype(auto) dispatch_neighbor_list(int max_points, Fn &&fn)
+    {
+        if (max_points <= 0)
+        {
+            throw std::invalid_argument("Max points must be positive");
+        }
+        const size_t limit = static_cast<size_t>(max_points);
+        if (limit <= 4)
+        {
+            InlineNeighborList<4> list(limit);
+            return fn(list);
+        }
+        if (limit <= 8)
+        {
+            InlineNeighborList<8> list(limit);
+            return fn(list);
+        }
+        if (limit <= 16)
+        {
+            InlineNeighborList<16> list(limit);
+            return fn(list);
+        }
+        DynamicNeighborList list(limit);
+        return fn(list);
+    }
+
+} // namespace fastregrid
+
+#endif // FASTREGRID_NEIGHBOR_LIST_H
@@ -0,0 +1,251 @@
+/*
+ * perf_counters.h
+ * Hardware performance counters (cycles, instructions, cache and branch misses) per thread in FastRegrid.
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#ifndef FASTREGRID_PERF_COUNTERS_H
+#define FASTREGRID_PERF_COUNTERS_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <string>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace fastregrid
+{
+
+    // Hardware events counted on one or more threads, in user space only.
+    struct HardwareCounters
+    {
+        uint64_t cycles = 0;
+        uint64_t instructions = 0;
+        uint64_t cache_misses = 0;  // Last-level cache misses
+        uint64_t branch_misses = 0; // Mispredicted branches
+
+        // Instructions per cycle (0 if no cycles were counted).
+        double ipc() const
+        {
+            return cycles ? static_cast<double>(instructions) / static_cast<double>(cycles) : 0.0;
+        }
+
+        HardwareCounters &operator+=(const HardwareCounters &other)
+        {
+            cycles += other.cycles;
+            instructions += other.instructions;
+            cache_misses += other.cache_misses;
+            branch_misses += other.branch_misses;
+            return *this;
+        }
+
+        // Counts since an earlier reading (saturating, as scaled readings of
+        // multiplexed counters can step back slightly).
+        HardwareCounters operator-(const HardwareCounters &earlier) const
+        {
+            auto since = [](uint64_t now, uint64_t then)
+            { return now > then ? now - then : 0; };
+            HardwareCounters delta;
+            delta.cycles = since(cycles, earlier.cycles);
+            delta.instructions = since(instructions, earlier.instructions);
+            delta.cache_misses = since(cache_misses, earlier.cache_misses);
+            delta.branch_misses = since(branch_misses, earlier.branch_misses);
+            return delta;
+        }
+    };
+
+    namespace perf
+    {
+
+        // Id of the calling thread as perf_event_open expects it (0 if unknown).
+        inline long thread_id()
+        {
+#if defined(__linux__)
+            return static_cast<long>(syscall(SYS_gettid));
+#else
+            return 0;
+#endif
+        }
+
+        // Counters of one thread, opened through perf_event_open as one group so
+        // they are scheduled together. Readable from any thread of the process.
+        // If the counters cannot be opened (non-Linux, no PMU, perf_event_paranoid
+        // or a seccomp filter in containers), valid() is false and reads give zeros.
+        class CounterGroup
+        {
+        public:
+            explicit CounterGroup(long tid)
+            {
+#if defined(__linux__)
+                static const uint64_t events[COUNTERS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                          PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+                for (size_t i = 0; i < COUNTERS; ++i)
+                {
+                    perf_event_attr attr;
+                    std::memset(&attr, 0, sizeof(attr));
+                    attr.size = sizeof(attr);
+                    attr.type = PERF_TYPE_HARDWARE;
+                    attr.config = events[i];
+                    attr.exclude_kernel = 1; // Allowed with perf_event_paranoid <= 2
+                    attr.exclude_hv = 1;
+                    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+                    const long fd = syscall(SYS_perf_event_open, &attr, static_cast<pid_t>(tid), -1,
+                                            leader_ < 0 ? -1 : leader_, 0);
+                    if (fd < 0)
+                    {
+                        if (leader_ < 0)
+                        {
+                            error_ = std::strerror(errno);
+                            return;
+                        }
+                        continue; // Event not supported by this CPU; reads as 0
+                    }
+                    if (leader_ < 0)
+                    {
+                        leader_ = static_cast<int>(fd);
+                    }
+                    else
+                    {
+                        fds_[members_] = static_cast<int>(fd);
+                    }
+                    slot_[members_++] = static_cast<int>(i);
+                }
+#else
+                (void)tid;
+                error_ = "not supported on this platform";
+#endif
+            }
+
+            CounterGroup(const CounterGroup &) = delete;
+            CounterGroup &operator=(const CounterGroup &) = delete;
+
+            ~CounterGroup()
+            {
+#if defined(__linux__)
+                for (size_t i = 1; i < members_; ++i)
+                {
+                    close(fds_[i]);
+                }
+                if (leader_ >= 0)
+                {
+                    close(leader_);
+                }
+#endif
+            }
+
+            bool valid() const { return leader_ >= 0; }
+
+            // Why the counters could not be opened (empty if valid).
+            const std::string &error() const { return error_; }
+
+            // Counts since the group was opened, scaled up if the kernel had to
+            // multiplex the counters with other users.
+            HardwareCounters read() const
+            {
+                HardwareCounters counters;
+#if defined(__linux__)
+                if (leader_ < 0)
+                {
+                    return counters;
+                }
+                uint64_t data[3 + COUNTERS] = {}; // nr, time enabled, time running, values
+                if (::read(leader_, data, sizeof(data)) < static_cast<ssize_t>(3 * sizeof(uint64_t)))
+                {
+                    return counters;
+                }
+                const double scale = data[2] && data[2] < data[1] ? static_cast<double>(data[1]) / static_cast<double>(data[2]) : 1.0;
+                uint64_t *fields[COUNTERS] = {&counters.cycles, &counters.instructions, &counters.cache_misses,
+                                              &counters.branch_misses};
+                for (size_t i = 0; i < members_ && i < data[0]; ++i)
+                {
+                    *fields[slot_[i]] = static_cast<uint64_t>(static_cast<double>(data[3 + i]) * scale);
+                }
+#endif
+                return counters;
+            }
+
+        private:
+            static constexpr size_t COUNTERS = 4;
+
+            int leader_ = -1;
+            int fds_[COUNTERS] = {-1, -1, -1, -1}; // Members after the leader
+            int slot_[COUNTERS] = {};              // Field of each member, in group order
+            size_t members_ = 0;
+            std::string error_;
+        };
+
+        // Whether stage timers read hardware counters. Off by default, as every
+        // reading is a system call; see Session.
+        inline std::atomic<bool> &enabled_flag()
+        {
+            static std::atomic<bool> enabled{false};
+            return enabled;
+        }
+
+        inline bool enabled() { return enabled_flag().load(std::memory_order_relaxed); }
+
+        // Counters of the calling thread since its first reading (zeros if
+        // unavailable). The group stays open for the life of the thread.
+        inline HardwareCounters thread_counters()
+        {
+            thread_local CounterGroup group(thread_id());
+            return group.read();
+        }
+
+        // Turns counter readings on for its lifetime if requested and the
+        // counters can be opened; otherwise available() is false and error()
+        // tells why. One session at a time.
+        class Session
+        {
+        public:
+            explicit Session(bool requested)
+            {
+                if (!requested)
+                {
+                    return;
+                }
+                CounterGroup probe(thread_id());
+                if (!probe.valid())
+                {
+                    error_ = probe.error();
+                    return;
+                }
+                available_ = true;
+                enabled_flag().store(true, std::memory_order_relaxed);
+            }
+
+            Session(const Session &) = delete;
+            Session &operator=(const Session &) = delete;
+
+            ~Session()
+            {
+                if (available_)
+                {
+                    enabled_flag().store(false, std::memory_order_relaxed);
+                }
+            }
+
+            bool available() const { return available_; }
+            const std::string &error() const { return error_; }
+
+        private:
+            bool available_ = false;
+            std::string error_;
+        };
+
+    } // namespace perf
+
+} // namespace fastregrid
+
+#endif // FASTREGRID_PERF_COUNTERS_H
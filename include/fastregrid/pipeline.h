@@ -0,0 +1,110 @@
+/*
+ * pipeline.h
+ * Bounded lock-free queues connecting the stages of the FastRegrid pipeline.
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#ifndef FASTREGRID_PIPELINE_H
+#define FASTREGRID_PIPELINE_H
+
+#include <atomic>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <utility>
+#include <stdexcept>
+#include <cstddef>
+
+namespace fastregrid
+{
+
+    // Single-producer, single-consumer ring buffer of fixed capacity. push()
+    // and pop() wait (spinning, then sleeping briefly) while the queue is full
+    // or empty. The producer calls close() when done; cancel() releases both
+    // sides early, e.g. when another stage failed.
+    template <typename T>
+    class SpscQueue
+    {
+    public:
+        explicit SpscQueue(size_t capacity) : slots_(capacity + 1)
+        {
+            if (capacity == 0)
+            {
+                throw std::invalid_argument("Queue capacity must be positive");
+            }
+        }
+
+        SpscQueue(const SpscQueue &) = delete;
+        SpscQueue &operator=(const SpscQueue &) = delete;
+
+        // Returns false (dropping item) if the queue was cancelled.
+        bool push(T item)
+        {
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            const size_t next = (tail + 1) % slots_.size();
+            for (unsigned spins = 0; next == head_.load(std::memory_order_acquire); ++spins)
+            {
+                if (cancelled_.load(std::memory_order_acquire))
+                {
+                    return false;
+                }
+                backoff(spins);
+            }
+            slots_[tail] = std::move(item);
+            tail_.store(next, std::memory_order_release);
+            return true;
+        }
+
+        // Returns false once the queue is closed and drained, or cancelled.
+        bool pop(T &item)
+        {
+            const size_t head = head_.load(std::memory_order_relaxed);
+            for (unsigned spins = 0; head == tail_.load(std::memory_order_acquire); ++spins)
+            {
+                if (cancelled_.load(std::memory_order_acquire))
+                {
+                    return false;
+                }
+                if (closed_.load(std::memory_order_acquire) && head == tail_.load(std::memory_order_acquire))
+                {
+                    return false;
+                }
+                backoff(spins);
+            }
+            item = std::move(slots_[head]);
+            slots_[head] = T();
+            head_.store((head + 1) % slots_.size(), std::memory_order_release);
+            return true;
+        }
+
+        void close() { closed_.store(true, std::memory_order_release); }
+        void cancel() { cancelled_.store(true, std::memory_order_release); }
+
+    private:
+        static void backoff(unsigned spins)
+        {
+            if (spins < 64)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+
+        std::vector<T> slots_;
+        alignas(64) std::atomic<size_t> head_{0};
+        alignas(64) std::atomic<size_t> tail_{0};
+        std::atomic<bool> closed_{false};
+        std::atomic<bool> cancelled_{false};
+    };
+
+} // namespace fastregrid
+
+#endif // FASTREGRID_PIPELINE_H
@@ -0,0 +1,390 @@
+/*
+ * query.h
+ * Low-latency point queries against a source field in FastRegrid.
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#ifndef FASTREGRID_QUERY_H
+#define FASTREGRID_QUERY_H
+
+#include "config.h"
+#include "types.h"
+#include "grid.h"
+#include "utils.h"
+#include "weights.h"
+#include "thread_pool.h"
+#include <array>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace fastregrid
+{
+
+    // Interpolates a source Field at arbitrary (lon, lat, time step) points,
+    // giving the same values a file regrid with the same config would give for
+    // a target row at that point. Sources are indexed once in latitude bands,
+    // sorted by longitude within each band, so a query only measures distances
+    // to sources near the point. query() never allocates and only reads shared
+    // state, so any number of threads may call it at once. Fallback warnings
+    // are not printed.
+    class PointQuery
+    {
+    public:
+        // Largest max_points supported (neighbours live on the caller's stack).
+        static constexpr size_t MAX_POINTS = 64;
+
+        PointQuery(Field source, RegridConfig config) : source_(std::move(source)), config_(std::move(config))
+        {
+            if (config_.interp_method != NEAREST_NEIGHBOR && config_.interp_method != INVERSE_DISTANCE_WEIGHTED)
+            {
+                throw std::invalid_argument("Unknown interpolation method");
+            }
+            if (config_.max_points <= 0 || static_cast<size_t>(config_.max_points) > MAX_POINTS)
+            {
+                throw std::invalid_argument("Point queries support max_points in [1, " + std::to_string(MAX_POINTS) + "]");
+            }
+            build_index();
+        }
+
+        // Loads the source file (within config.memory_budget, as for regrid()).
+        PointQuery(const std::string &source_file, const RegridConfig &config)
+            : PointQuery(Field::load(source_file, config), config)
+        {
+        }
+
+        PointQuery(const PointQuery &) = delete;
+        PointQuery &operator=(const PointQuery &) = delete;
+
+        const Field &source() const { return source_; }
+        const RegridConfig &config() const { return config_; }
+        size_t stride() const { return source_.stride(); }
+
+        // Writes the stride() values at (lon, lat, time_step) to values and returns
+        // true, or returns false if no neighbouring source has that time step.
+        bool query(double lon, double lat, int time_step, ValueType *values) const
+        {
+            if (config_.adjust_longitude)
+            {
+                lon = utils::adjust_longitude(lon);
+            }
+            if (!(std::abs(lat) <= 90.0) || !(std::abs(lon) <= 360.0))
+            {
+                throw std::invalid_argument("Query point out of range: (" + std::to_string(lon) + ", " +
+                                            std::to_string(lat) + ")");
+            }
+
+            Neighbors neighbors;
+            if (config_.interp_method == NEAREST_NEIGHBOR)
+            {
+                neighbors.add(nearest(lon, lat), ValueType(1));
+            }
+            else
+            {
+                idw_neighbors(lon, lat, neighbors);
+            }
+
+            const size_t stride = source_.stride();
+            const size_t time_idx = source_.time_index(time_step);
+            std::fill(values, values + stride, ValueType(0));
+            ValueType weight_sum = 0;
+            for (size_t k = 0; k < neighbors.size; ++k)
+            {
+                const size_t location = neighbors.location[k];
+                if (time_idx == Field::npos || !source_.has(time_idx, location))
+                {
+                    continue;
+                }
+                const ValueType w = neighbors.weight[k];
+                const ValueType *source_values = source_.values(time_idx, location);
+                weight_sum += w;
+                for (size_t j = 0; j < stride; ++j)
+                {
+                    values[j] += w * source_values[j];
+                }
+            }
+            if (weight_sum == 0)
+            {
+                return false;
+            }
+            for (size_t j = 0; j < stride; ++j)
+            {
+                values[j] /= weight_sum;
+            }
+            return true;
+        }
+
+        // Queries count points on the thread pool. Point i writes stride() values
+        // at values[i * stride()] and found[i] (may be null); returns the number found.
+        size_t query(const double *lons, const double *lats, const int *time_steps, size_t count,
+                     ValueType *values, uint8_t *found = nullptr) const
+        {
+            std::atomic<size_t> total{0};
+            ThreadPool &pool = pool_for(config_);
+            pool.parallel_for(0, count, pool.grain(count, config_.chunk_size), [&](size_t begin, size_t end)
+                              {
+                size_t local = 0;
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const bool ok = query(lons[i], lats[i], time_steps[i], values + i * stride());
+                    local += ok;
+                    if (found)
+                    {
+                        found[i] = ok;
+                    }
+                }
+                total += local; });
+            return total.load();
+        }
+
+    private:
+        // Neighbours of one point, nearest first, with their raw weights.
+        struct Neighbors
+        {
+            std::array<size_t, MAX_POINTS> location;
+            std::array<ValueType, MAX_POINTS> weight;
+            size_t size = 0;
+
+            void add(size_t source_location, ValueType w)
+            {
+                location[size] = source_location;
+                weight[size++] = w;
+            }
+        };
+
+        // The limit nearest (distance, location) pairs seen, ordered by distance
+        // and then location, which matches the full scan's "earlier source wins".
+        struct Candidates
+        {
+            std::array<double, MAX_POINTS> distance;
+            std::array<size_t, MAX_POINTS> location;
+            size_t size = 0;
+            size_t limit;
+            size_t offered = 0;
+
+            explicit Candidates(size_t max) : limit(max) {}
+
+            static bool before(double d1, size_t l1, double d2, size_t l2)
+            {
+                return d1 < d2 || (d1 == d2 && l1 < l2);
+            }
+
+            void offer(double d, size_t l)
+            {
+                ++offered;
+                if (size == limit && !before(d, l, distance[size - 1], location[size - 1]))
+                {
+                    return;
+                }
+                size_t pos = size < limit ? size++ : size - 1;
+                while (pos > 0 && before(d, l, distance[pos - 1], location[pos - 1]))
+                {
+                    distance[pos] = distance[pos - 1];
+                    location[pos] = location[pos - 1];
+                    --pos;
+                }
+                distance[pos] = d;
+                location[pos] = l;
+            }
+        };
+
+        static constexpr double EARTH_RADIUS_KM = 6371.0;
+
+        void build_index()
+        {
+            const Grid &grid = source_.grid();
+            const size_t count = grid.size();
+            if (count == 0)
+            {
+                throw std::runtime_error("Source point list is empty");
+            }
+            // Bands about one search radius high keep the scanned area close to the search disc
+            const double radius_deg = config_.distance_metric == HAVERSINE ? config_.radius / EARTH_RADIUS_KM * 180.0 / M_PI
+                                                                           : utils::km_to_degrees(config_.radius, 0.0);
+            band_height_ = std::min(10.0, std::max(0.1, radius_deg));
+            bands_ = static_cast<size_t>(std::ceil(180.0 / band_height_));
+
+            std::vector<size_t> order(count);
+            std::iota(order.begin(), order.end(), size_t(0));
+            std::vector<size_t> band_of(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                band_of[i] = band(grid.latitude(i));
+            }
+            std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                      {
+                if (band_of[a] != band_of[b])
+                {
+                    return band_of[a] < band_of[b];
+                }
+                return grid.longitude(a) < grid.longitude(b) || (grid.longitude(a) == grid.longitude(b) && a < b); });
+
+            lons_.resize(count);
+            lats_.resize(count);
+            locations_.resize(count);
+            band_begin_.assign(bands_ + 1, 0);
+            for (size_t i = 0; i < count; ++i)
+            {
+                lons_[i] = grid.longitude(order[i]);
+                lats_[i] = grid.latitude(order[i]);
+                locations_[i] = order[i];
+                ++band_begin_[band_of[order[i]] + 1];
+            }
+            for (size_t b = 0; b < bands_; ++b)
+            {
+                band_begin_[b + 1] += band_begin_[b];
+            }
+        }
+
+        size_t band(double lat) const
+        {
+            const double b = std::floor((lat + 90.0) / band_height_);
+            return static_cast<size_t>(std::min<double>(bands_ - 1, std::max(0.0, b)));
+        }
+
+        // Calls fn(i) for every indexed source i that may lie within distance
+        // (in metric units) of (lon, lat); returns false if that covered every source.
+        template <typename Fn>
+        bool for_each_candidate(double lon, double lat, double distance, Fn &&fn) const
+        {
+            double reach_lat;
+            double reach_lon = -1.0; // Negative: every longitude
+            bool wrap = false;
+            if (config_.distance_metric == HAVERSINE)
+            {
+                const double d = distance / EARTH_RADIUS_KM;
+                reach_lat = d * 180.0 / M_PI;
+                const double cos_lat = std::cos(utils::to_radians(lat));
+                if (d < M_PI / 2 && std::sin(d) < cos_lat)
+                {
+                    reach_lon = std::asin(std::sin(d) / cos_lat) * 180.0 / M_PI * (1.0 + 1e-9) + 1e-9;
+                }
+                wrap = true;
+            }
+            else
+            {
+                reach_lat = distance;
+                reach_lon = distance * (1.0 + 1e-12) + 1e-12;
+            }
+            reach_lat = reach_lat * (1.0 + 1e-9) + 1e-9;
+
+            const bool everything = lat - reach_lat <= -90.0 && lat + reach_lat >= 90.0 &&
+                                    (reach_lon < 0.0 || (!wrap && reach_lon >= 720.0));
+            const size_t first = band(lat - reach_lat);
+            const size_t last = band(lat + reach_lat);
+            for (size_t b = first; b <= last; ++b)
+            {
+                const double *begin = lons_.data() + band_begin_[b];
+                const double *end = lons_.data() + band_begin_[b + 1];
+                if (reach_lon < 0.0)
+                {
+                    for (const double *p = begin; p != end; ++p)
+                    {
+                        fn(static_cast<size_t>(p - lons_.data()));
+                    }
+                    continue;
+                }
+                // Haversine distances wrap around in longitude; source and query
+                // longitudes may each lie anywhere in [-360, 360]
+                for (double shift : {-720.0, -360.0, 0.0, 360.0, 720.0})
+                {
+                    if (shift != 0.0 && !wrap)
+                    {
+                        continue;
+                    }
+                    const double *lo = std::lower_bound(begin, end, lon + shift - reach_lon);
+                    const double *hi = std::upper_bound(lo, end, lon + shift + reach_lon);
+                    for (const double *p = lo; p != hi; ++p)
+                    {
+                        fn(static_cast<size_t>(p - lons_.data()));
+                    }
+                }
+            }
+            return !everything;
+        }
+
+        double distance_to(double lon, double lat, size_t i) const
+        {
+            return utils::compute_distance(lon, lat, lons_[i], lats_[i], config_.distance_metric);
+        }
+
+        // Location of the nearest source (lowest location on ties), searching
+        // rings of growing distance until one holds a source within it.
+        size_t nearest(double lon, double lat) const
+        {
+            double reach = config_.distance_metric == HAVERSINE ? band_height_ * M_PI / 180.0 * EARTH_RADIUS_KM
+                                                                : band_height_;
+            while (true)
+            {
+                double best = std::numeric_limits<double>::max();
+                size_t best_location = 0;
+                const bool partial = for_each_candidate(lon, lat, reach, [&](size_t i)
+                                                        {
+                    const double d = distance_to(lon, lat, i);
+                    if (Candidates::before(d, locations_[i], best, best_location))
+                    {
+                        best = d;
+                        best_location = locations_[i];
+                    } });
+                if (!partial || best <= reach)
+                {
+                    return best_location;
+                }
+                reach *= 4.0;
+            }
+        }
+
+        // IDW neighbours within the radius, or the nearest source as a fallback
+        // when fewer than min_points are in range, with the weights RegridWeights uses.
+        void idw_neighbors(double lon, double lat, Neighbors &neighbors) const
+        {
+            const double radius = config_.distance_metric == EUCLIDEAN ? utils::km_to_degrees(config_.radius, lat)
+                                                                       : config_.radius;
+            Candidates candidates(static_cast<size_t>(config_.max_points));
+            for_each_candidate(lon, lat, radius, [&](size_t i)
+                               {
+                const double d = distance_to(lon, lat, i);
+                if (d <= radius)
+                {
+                    candidates.offer(d, locations_[i]);
+                } });
+            if (candidates.offered < static_cast<size_t>(config_.min_points))
+            {
+                neighbors.add(nearest(lon, lat), ValueType(1));
+                return;
+            }
+            for (size_t k = 0; k < candidates.size; ++k)
+            {
+                // Euclidean distances in km as SpatialIndex converts them
+                const double distance = config_.distance_metric == EUCLIDEAN
+                                            ? candidates.distance[k] * 111.32 * std::cos(utils::to_radians(lat))
+                                            : candidates.distance[k];
+                neighbors.add(candidates.location[k],
+                              static_cast<ValueType>(RegridWeights::idw_weight(distance, config_.power)));
+            }
+        }
+
+        Field source_;
+        RegridConfig config_;
+        double band_height_ = 1.0;
+        size_t bands_ = 0;
+        std::vector<size_t> band_begin_; // Index range of each band, bands_ + 1 entries
+        std::vector<double> lons_;       // Sources by band, then longitude
+        std::vector<double> lats_;
+        std::vector<size_t> locations_; // Grid location of each indexed source
+    };
+
+} // namespace fastregrid
+
+#endif // FASTREGRID_QUERY_H
@@ -14,120 +14,961 @@
 
 #include "config.h"
 #include "types.h"
+#include "grid_store.h"
 #include "io.h"
+#include "grid.h"
+#include "memory.h"
+#include "arena.h"
 #include "spatial_index.h"
 #include "interpolation.h"
+#include "weights.h"
+#include "tiling.h"
+#include "thread_pool.h"
+#include "pipeline.h"
+#include "checkpoint.h"
+#include "stats.h"
+#include "logger.h"
+#include "warnings.h"
+#include "trace.h"
 #include <string>
 #include <vector>
 #include <stdexcept>
 #include <iostream>
+#include <memory>
+#include <fstream>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <exception>
+#include <sstream>
+#include <cstdio>
+#include <chrono>
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace fastregrid
 {
 
+    // One target of a fan-out regrid: its file and output directory.
+    struct RegridTarget
+    {
+        std::string target_file;
+        std::string output_path;
+    };
+
     class Regridder
     {
     public:
         // Constructor initializes with source and target file paths and config
         Regridder(const std::string &source_file, const std::string &target_file, const RegridConfig &config)
-            : source_file_(source_file), target_file_(target_file), config_(config)
+            : Regridder(source_file, std::vector<RegridTarget>{{target_file, config.output_path}}, config)
+        {
+        }
+
+        // Fan-out: regrids one source onto several targets, each written to its
+        // own output directory. The source is read and indexed once.
+        Regridder(const std::string &source_file, std::vector<RegridTarget> targets, const RegridConfig &config)
+            : source_file_(source_file), targets_(std::move(targets)), config_(config)
         {
-            if (source_file_.empty() || target_file_.empty())
+            if (source_file_.empty() || targets_.empty())
             {
                 throw std::runtime_error("Source or target file path is empty");
             }
+            for (const auto &target : targets_)
+            {
+                if (target.target_file.empty())
+                {
+                    throw std::runtime_error("Source or target file path is empty");
+                }
+            }
         }
 
-        // Executes the regridding pipeline
-        void regrid() const
+        // Executes the regridding pipeline and returns what it did and cost. With
+        // config.write_stats, the stats are also written to config.stats_file in
+        // every output directory (with several targets, the totals over all);
+        // with config.write_trace, a timeline of the run to config.trace_file.
+        RegridStats regrid() const
         {
+            const auto start = std::chrono::steady_clock::now();
+            const double cpu_start = stats::process_cpu_seconds();
+            RegridStats run_stats;
+            trace::Recording recording(config_.write_trace);
+            trace::set_thread_name("regrid");
+            perf::Session counters(config_.hardware_counters);
+            run_stats.hardware_counters = counters.available();
+            if (config_.hardware_counters && !counters.available())
+            {
+                log_warning("Hardware counters unavailable ({}); stats report times only", counters.error());
+            }
+
             // Step 1: Read source and target data
             InputReader source_reader(source_file_, config_);
-            InputReader target_reader(target_file_, config_);
 
             if (config_.verbose)
             {
                 std::cout << "Reading source data from: " << source_file_ << std::endl;
-                std::cout << "Reading target data from: " << target_file_ << std::endl;
             }
 
-            std::vector<SpatialData> source_points = source_reader.read_grid();
-            std::vector<SpatialData> target_points = target_reader.read_grid();
             std::vector<std::string> headers = source_reader.read_headers();
 
-            // Validate headers
-            std::vector<std::string> target_headers = target_reader.read_headers();
-            if (headers.size() < 3 || target_headers.size() < 3)
+            // Validate headers of every target before any work is done
+            for (const auto &target : targets_)
             {
-                throw std::runtime_error("Invalid headers in source or target file");
+                validate_headers(headers, InputReader(target.target_file, config_).read_headers(), config_);
             }
-            if (config_.data_layout == GRID_BY_TIME && headers.size() != 15)
+
+            if (config_.tile_size > 0.0)
             {
-                throw std::runtime_error("GRID_BY_TIME requires 12 monthly value columns plus Lon, Lat, Year");
+                if (targets_.size() > 1)
+                {
+                    throw std::invalid_argument("Tiled mode supports a single target");
+                }
+                {
+                    stats::StageTimer timer(run_stats.total, &pool_for(config_)); // Counters only; times set at the end
+                    regrid_tiled(source_reader, InputReader(targets_[0].target_file, config_), headers, run_stats);
+                }
+                return finish_run(run_stats, start, cpu_start, recording);
             }
-            if (headers.size() != target_headers.size())
+
+            // Split rows into geometry (unique locations) and values over grid x time.
+            // With a memory budget, source values are streamed (and spilled if needed)
+            // instead of being held twice.
+            const LargeBufferPolicy policy = buffer_policy(config_);
+            Field source_field = [&]()
             {
-                throw std::runtime_error("Source and target files have different number of columns");
-            }
+                stats::StageTimer timer(run_stats.read_source, &pool_for(config_));
+                trace::Scope scope("read source");
+                const int64_t source_bytes = std::max<int64_t>(0, file_size(source_file_));
+                if (config_.memory_budget != 0)
+                {
+                    size_t rows = 0;
+                    Field field = Field::load(source_file_, config_, &rows);
+                    run_stats.rows_read += rows;
+                    run_stats.bytes_read += 2 * static_cast<uint64_t>(source_bytes); // Parsed twice
+                    return field;
+                }
+                GridStore source_points = source_reader.read_grid();
+                run_stats.rows_read += source_points.size();
+                run_stats.bytes_read += static_cast<uint64_t>(source_bytes);
+                auto grid = std::make_shared<const Grid>(source_points, policy);
+                return Field(source_points, grid, policy, &pool_for(config_));
+            }();
+            // One warning summary for the whole run, reported at its end
+            WarningSummary warnings(config_.radius, config_.warning_examples);
+            SpatialIndex index(source_field.grid(), config_, &warnings);
+            Interpolator interpolator(source_field, config_, &warnings);
 
-            // Write gridlists if verbose
-            source_reader.write_gridlist("source_gridlist.txt");
-            target_reader.write_gridlist("target_gridlist.txt");
+            for (const auto &target : targets_)
+            {
+                if (config_.verbose)
+                {
+                    std::cout << "Reading target data from: " << target.target_file << std::endl;
+                }
+                RegridConfig target_config = config_;
+                target_config.output_path = target.output_path;
+                OutputWriter writer(target_config);
+                regrid_target(InputReader(target.target_file, config_), target.target_file, headers, source_field,
+                              index, interpolator, writer, run_stats);
+            }
 
-            // Step 2: Compute spatial mappings
+            warnings.report();
             if (config_.verbose)
             {
-                std::cout << "Computing spatial mappings..." << std::endl;
+                FastRegridLogger::getInstance().flush(); // Warnings of the run come first
+                std::cout << "Regridding completed successfully." << std::endl;
             }
-            SpatialIndex index(source_points, config_);
-            std::vector<std::tuple<double, double, double, double, double, size_t>> nn_mappings;
-            std::vector<std::tuple<double, double, std::vector<std::tuple<double, double, double>>, size_t, bool>> idw_mappings;
+            return finish_run(run_stats, start, cpu_start, recording);
+        }
 
-            if (config_.interp_method == NEAREST_NEIGHBOR || config_.write_mappings)
+        // In-memory regridding over caller-owned buffers: no file I/O and no
+        // copies of coordinates or values. Source location i holds count values at
+        // source_values[i * source_stride]; results for target location t are
+        // written to target_values[t * target_stride]. Several time steps can be
+        // regridded at once by laying them out within one location's stride.
+        static void regrid(Span<const double> source_lons, Span<const double> source_lats,
+                           const ValueType *source_values, size_t source_stride,
+                           Span<const double> target_lons, Span<const double> target_lats,
+                           ValueType *target_values, size_t target_stride,
+                           size_t count, const RegridConfig &config)
+        {
+            if (source_lons.size() != source_lats.size() || target_lons.size() != target_lats.size())
             {
-                nn_mappings = index.find_nearest_neighbors(target_points);
+                throw std::invalid_argument("Longitude and latitude arrays differ in length");
             }
-            if (config_.interp_method == INVERSE_DISTANCE_WEIGHTED || config_.write_mappings)
+            if (count > source_stride || count > target_stride)
             {
-                idw_mappings = index.find_idw_neighbors(target_points);
+                throw std::invalid_argument("Value count exceeds buffer stride");
             }
+            if (!source_values || !target_values)
+            {
+                throw std::invalid_argument("Value buffers must not be null");
+            }
+            RegridWeights weights = RegridWeights::build(source_lons.data(), source_lats.data(), source_lons.size(),
+                                                         target_lons.data(), target_lats.data(), target_lons.size(),
+                                                         config);
+            weights.apply(source_values, source_stride, target_values, target_stride, count);
+        }
 
-            // Step 3: Interpolate values
+    private:
+        // Fills in the totals of a run and writes its stats and trace files if configured.
+        RegridStats finish_run(RegridStats &run_stats, std::chrono::steady_clock::time_point start,
+                               double cpu_start, const trace::Recording &recording) const
+        {
+            run_stats.total.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            run_stats.total.cpu_seconds = stats::process_cpu_seconds() - cpu_start;
+            run_stats.peak_memory_bytes = stats::peak_memory_bytes();
+            for (const StageTimes *stage : {&run_stats.read_source, &run_stats.parse, &run_stats.search,
+                                            &run_stats.interpolate, &run_stats.format, &run_stats.write})
+            {
+                run_stats.total.counters += stage->counters;
+            }
+            if (config_.write_stats)
+            {
+                for (const auto &target : targets_)
+                {
+                    RegridConfig target_config = config_;
+                    target_config.output_path = target.output_path;
+                    run_stats.write_json(OutputWriter(target_config).path(config_.stats_file));
+                }
+            }
+            for (const auto &target : targets_)
+            {
+                RegridConfig target_config = config_;
+                target_config.output_path = target.output_path;
+                recording.write(OutputWriter(target_config).path(config_.trace_file));
+            }
+            return run_stats;
+        }
+
+        // Streams the rows of one target file through
+        //   parse -> map + interpolate -> format -> write
+        // with one thread per stage (map + interpolate runs on the calling thread,
+        // using the thread pool) and bounded queues between them, so I/O overlaps
+        // compute. Outputs go to writer's directory. With config.checkpoint_interval,
+        // progress is checkpointed every that many chunks, and a valid checkpoint
+        // left by an interrupted run is resumed from. Adds to run_stats.
+        void regrid_target(const InputReader &target_reader, const std::string &target_file,
+                           const std::vector<std::string> &headers, const Field &source_field,
+                           const SpatialIndex &index, const Interpolator &interpolator,
+                           const OutputWriter &writer, RegridStats &run_stats) const
+        {
             if (config_.verbose)
             {
-                std::cout << "Interpolating values..." << std::endl;
+                std::cout << "Mapping and interpolating target rows..." << std::endl;
+            }
+            const LargeBufferPolicy policy = buffer_policy(config_);
+            const std::shared_ptr<const Grid> &source_grid = source_field.grid_ptr();
+            writer.write_gridlist(source_grid->longitudes(), source_grid->latitudes(), "source_gridlist.txt");
+            run_stats.bytes_written += static_cast<uint64_t>(file_size(writer.path("source_gridlist.txt")));
+            run_stats.bytes_read += static_cast<uint64_t>(std::max<int64_t>(0, file_size(target_file)));
+
+            const std::string checkpoint_file = writer.path(config_.checkpoint_file);
+            Checkpoint progress;
+            progress.source = FileStamp::of(source_file_);
+            progress.target = FileStamp::of(target_file);
+            progress.settings = Checkpoint::settings_of(config_);
+            const bool resume = config_.checkpoint_interval != 0 && resume_from(checkpoint_file, writer, progress);
+            const size_t resume_row = resume ? progress.next_row : 0;
+
+            constexpr size_t QUEUE_CAPACITY = 4;
+            SpscQueue<std::unique_ptr<TargetChunk>> parsed(QUEUE_CAPACITY);
+            SpscQueue<std::unique_ptr<TargetChunk>> interpolated(QUEUE_CAPACITY);
+            SpscQueue<std::unique_ptr<TargetChunk>> formatted(QUEUE_CAPACITY);
+            std::exception_ptr error;
+            std::mutex error_mutex;
+            auto fail = [&]()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (!error)
+                    {
+                        error = std::current_exception();
+                    }
+                }
+                parsed.cancel();
+                interpolated.cancel();
+                formatted.cancel();
+            };
+
+            const size_t num_arenas = pool_for(config_).size();
+            LargeVector<double> target_lons(LargeBufferAllocator<double>{policy});
+            LargeVector<double> target_lats(LargeBufferAllocator<double>{policy});
+            size_t target_rows = 0;
+            std::thread parse_stage([&]()
+                                    {
+                try
+                {
+                    trace::set_thread_name("parse stage");
+                    stats::StageTimer timer(run_stats.parse);
+                    trace::Scope scope("parse", "first_row", 0);
+                    const size_t chunk_rows = std::max<size_t>(1, config_.chunk_size);
+                    auto chunk = std::make_unique<TargetChunk>(0, num_arenas, policy);
+                    chunk->skip = resume_row > 0;
+                    size_t rows = target_reader.scan([&](double lon, double lat, int time_step, const ValueType *, size_t)
+                                                     {
+                        chunk->targets.push_back(lon, lat, time_step);
+                        if (chunk->targets.size() == chunk_rows)
+                        {
+                            size_t next_row = chunk->first_row + chunk_rows;
+                            if (!timer.idle([&]()
+                                            { return parsed.push(std::move(chunk)); }))
+                            {
+                                throw std::runtime_error("Pipeline cancelled");
+                            }
+                            chunk = std::make_unique<TargetChunk>(next_row, num_arenas, policy);
+                            chunk->skip = next_row < resume_row;
+                            scope.next(next_row);
+                        } });
+                    target_rows = rows;
+                    if (rows == 0)
+                    {
+                        throw std::runtime_error("Empty input file: " + target_file);
+                    }
+                    if (!chunk->targets.empty())
+                    {
+                        timer.idle([&]()
+                                   { return parsed.push(std::move(chunk)); });
+                    }
+                    parsed.close();
+                }
+                catch (...)
+                {
+                    fail();
+                } });
+
+            std::thread format_stage([&]()
+                                     {
+                try
+                {
+                    trace::set_thread_name("format stage");
+                    stats::StageTimer timer(run_stats.format);
+                    std::unique_ptr<TargetChunk> chunk;
+                    while (timer.idle([&]()
+                                      { return interpolated.pop(chunk); }))
+                    {
+                        trace::Scope scope("format", "first_row", chunk->first_row);
+                        if (chunk->skip)
+                        {
+                            chunk->release();
+                            if (!timer.idle([&]()
+                                            { return formatted.push(std::move(chunk)); }))
+                            {
+                                return;
+                            }
+                            continue;
+                        }
+                        std::ostringstream rows;
+                        writer.write_rows(rows, chunk->results);
+                        chunk->text = rows.str();
+                        if (config_.write_mappings)
+                        {
+                            std::ostringstream nn, idw;
+                            writer.write_nn_mapping_rows(nn, chunk->nn_mappings, &chunk->row_locations, chunk->first_row);
+                            writer.write_idw_mapping_rows(idw, chunk->idw_mappings, &chunk->row_locations, chunk->first_row);
+                            chunk->nn_text = nn.str();
+                            chunk->idw_text = idw.str();
+                        }
+                        chunk->release();
+                        if (!timer.idle([&]()
+                                        { return formatted.push(std::move(chunk)); }))
+                        {
+                            return;
+                        }
+                    }
+                    formatted.close();
+                }
+                catch (...)
+                {
+                    fail();
+                } });
+
+            size_t rows_written = resume ? progress.rows_written : 0;
+            const size_t resumed_rows = rows_written;
+            uint64_t bytes_written = 0;
+            std::thread write_stage([&]()
+                                    {
+                try
+                {
+                    trace::set_thread_name("write stage");
+                    stats::StageTimer timer(run_stats.write);
+                    // On resume, outputs were truncated to the checkpoint and are continued
+                    const std::ios::openmode mode = resume ? std::ios::in | std::ios::out : std::ios::out;
+                    std::ofstream data(writer.path("regridded.txt"), mode);
+                    std::ofstream nn_file, idw_file;
+                    if (!data.is_open())
+                    {
+                        throw std::runtime_error("Cannot open output file: " + writer.path("regridded.txt"));
+                    }
+                    if (config_.write_mappings)
+                    {
+                        nn_file.open(writer.path(config_.nn_mappings_file), mode);
+                        idw_file.open(writer.path(config_.idw_mappings_file), mode);
+                        if (!nn_file.is_open() || !idw_file.is_open())
+                        {
+                            throw std::runtime_error("Cannot open mappings files in: " + writer.path(""));
+                        }
+                    }
+                    if (resume)
+                    {
+                        data.seekp(0, std::ios::end);
+                        if (config_.write_mappings)
+                        {
+                            nn_file.seekp(0, std::ios::end);
+                            idw_file.seekp(0, std::ios::end);
+                        }
+                    }
+                    else
+                    {
+                        writer.write_headers(data, headers);
+                        if (config_.write_mappings)
+                        {
+                            writer.write_nn_mapping_header(nn_file);
+                            writer.write_idw_mapping_header(idw_file);
+                        }
+                    }
+                    const std::streamoff data_start = resume ? static_cast<std::streamoff>(data.tellp()) : 0;
+                    const bool resume_mappings = resume && config_.write_mappings;
+                    const std::streamoff nn_start = resume_mappings ? static_cast<std::streamoff>(nn_file.tellp()) : 0;
+                    const std::streamoff idw_start = resume_mappings ? static_cast<std::streamoff>(idw_file.tellp()) : 0;
+                    size_t chunks_since_checkpoint = 0;
+                    std::unique_ptr<TargetChunk> chunk;
+                    while (timer.idle([&]()
+                                      { return formatted.pop(chunk); }))
+                    {
+                        if (chunk->skip)
+                        {
+                            continue;
+                        }
+                        trace::Scope scope("write", "first_row", chunk->first_row);
+                        data << chunk->text;
+                        if (config_.write_mappings)
+                        {
+                            nn_file << chunk->nn_text;
+                            idw_file << chunk->idw_text;
+                        }
+                        rows_written += chunk->rows_kept;
+                        if (!data || (config_.write_mappings && (!nn_file || !idw_file)))
+                        {
+                            throw std::runtime_error("Cannot write outputs to: " + writer.path(""));
+                        }
+                        if (config_.checkpoint_interval != 0 && ++chunks_since_checkpoint == config_.checkpoint_interval)
+                        {
+                            data.flush();
+                            progress.data_bytes = static_cast<uint64_t>(data.tellp());
+                            if (config_.write_mappings)
+                            {
+                                nn_file.flush();
+                                idw_file.flush();
+                                progress.nn_bytes = static_cast<uint64_t>(nn_file.tellp());
+                                progress.idw_bytes = static_cast<uint64_t>(idw_file.tellp());
+                            }
+                            progress.next_row = chunk->end_row;
+                            progress.rows_written = rows_written;
+                            trace::Scope checkpoint_scope("checkpoint", "next_row", progress.next_row);
+                            progress.save(checkpoint_file);
+                            chunks_since_checkpoint = 0;
+                        }
+                    }
+                    bytes_written = static_cast<uint64_t>(static_cast<std::streamoff>(data.tellp()) - data_start);
+                    if (config_.write_mappings)
+                    {
+                        bytes_written += static_cast<uint64_t>(static_cast<std::streamoff>(nn_file.tellp()) - nn_start) +
+                                         static_cast<uint64_t>(static_cast<std::streamoff>(idw_file.tellp()) - idw_start);
+                    }
+                }
+                catch (...)
+                {
+                    fail();
+                } });
+
+            try
+            {
+                std::unique_ptr<TargetChunk> chunk;
+                while (parsed.pop(chunk))
+                {
+                    map_and_interpolate(*chunk, index, interpolator, source_grid->size(), target_lons, target_lats,
+                                        run_stats);
+                    if (!interpolated.push(std::move(chunk)))
+                    {
+                        break;
+                    }
+                }
+                interpolated.close();
+            }
+            catch (...)
+            {
+                fail();
+            }
+            parse_stage.join();
+            format_stage.join();
+            write_stage.join();
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+            if (rows_written == 0)
+            {
+                throw std::runtime_error(config_.interp_method == NEAREST_NEIGHBOR ? "No points interpolated in NN mode"
+                                                                                   : "No points interpolated in IDW mode");
+            }
+
+            Grid target_grid(target_lons.data(), target_lats.data(), target_lons.size(), policy);
+            writer.write_gridlist(target_grid.longitudes(), target_grid.latitudes(), "target_gridlist.txt");
+            run_stats.rows_read += target_rows;
+            run_stats.rows_written += rows_written - resumed_rows;
+            run_stats.bytes_written += bytes_written + static_cast<uint64_t>(file_size(writer.path("target_gridlist.txt")));
+            if (config_.checkpoint_interval != 0)
+            {
+                std::remove(checkpoint_file.c_str());
             }
-            Interpolator interpolator(source_points, config_);
-            std::vector<SpatialData> interpolated_points = interpolator.interpolate(target_points, nn_mappings, idw_mappings);
 
-            // Step 4: Write outputs
             if (config_.verbose)
             {
-                std::cout << "Writing outputs to: " << config_.output_path << std::endl;
+                std::cout << "Outputs written to: " << writer.path("") << std::endl;
             }
-            OutputWriter writer(config_);
+        }
+
+        // Target rows flowing through the streaming pipeline, with everything
+        // derived from them. Neighbour lists live on the chunk's own arena.
+        struct TargetChunk
+        {
+            TargetChunk(size_t first, size_t num_arenas, const LargeBufferPolicy &policy)
+                : first_row(first), targets(0, policy), arenas(num_arenas, 64 << 10) {}
+
+            // Drops everything the write stage does not need.
+            void release()
+            {
+                targets = GridStore();
+                results = GridStore();
+                row_locations = std::vector<size_t>();
+                nn_mappings = std::vector<NNMapping>();
+                idw_mappings = std::vector<IDWMapping>();
+                arenas.release();
+            }
+
+            size_t first_row;
+            size_t end_row = 0;              // One past the last target row
+            bool skip = false;               // Written before the resumed checkpoint
+            GridStore targets;               // Coordinates and time steps (stride 0)
+            ArenaSet arenas;                 // Declared before the mappings that allocate from it
+            std::vector<size_t> row_locations;
+            std::vector<NNMapping> nn_mappings;
+            std::vector<IDWMapping> idw_mappings;
+            GridStore results;
+            size_t rows_kept = 0;
+            std::string text, nn_text, idw_text;
+        };
+
+        // Validates the checkpoint of an interrupted run against progress (inputs
+        // and settings of this run) and the outputs on disk. If it can be resumed,
+        // truncates the outputs to it, copies it into progress and returns true.
+        bool resume_from(const std::string &checkpoint_file, const OutputWriter &writer, Checkpoint &progress) const
+        {
+            std::optional<Checkpoint> saved = Checkpoint::load(checkpoint_file);
+            if (!saved)
+            {
+                return false;
+            }
+            const std::string data_file = writer.path("regridded.txt");
+            const std::string nn_file = writer.path(config_.nn_mappings_file);
+            const std::string idw_file = writer.path(config_.idw_mappings_file);
+            const char *reason = nullptr;
+            if (!(saved->source == progress.source) || !(saved->target == progress.target))
+            {
+                reason = "input files changed";
+            }
+            else if (saved->settings != progress.settings)
+            {
+                reason = "settings changed";
+            }
+            else if (file_size(data_file) < static_cast<int64_t>(saved->data_bytes) ||
+                     (config_.write_mappings && (file_size(nn_file) < static_cast<int64_t>(saved->nn_bytes) ||
+                                                 file_size(idw_file) < static_cast<int64_t>(saved->idw_bytes))))
+            {
+                reason = "outputs are missing or shorter than recorded";
+            }
+            if (reason)
+            {
+                if (config_.verbose)
+                {
+                    log_warning("Ignoring checkpoint {}: {}", checkpoint_file, reason);
+                }
+                return false;
+            }
+
+            truncate_file(data_file, saved->data_bytes);
             if (config_.write_mappings)
             {
-                if (!nn_mappings.empty())
+                truncate_file(nn_file, saved->nn_bytes);
+                truncate_file(idw_file, saved->idw_bytes);
+            }
+            progress = *saved;
+            if (config_.verbose)
+            {
+                std::cout << "Resuming from checkpoint at target row " << progress.next_row << " ("
+                          << progress.rows_written << " rows written)" << std::endl;
+            }
+            return true;
+        }
+
+        // Maps the chunk's unique target locations to sources and interpolates its
+        // rows. The locations are appended to target_lons/target_lats.
+        void map_and_interpolate(TargetChunk &chunk, const SpatialIndex &index, const Interpolator &interpolator,
+                                 size_t source_size, LargeVector<double> &target_lons,
+                                 LargeVector<double> &target_lats, RegridStats &run_stats) const
+        {
+            const LargeBufferPolicy policy = buffer_policy(config_);
+            ThreadPool &pool = pool_for(config_);
+            chunk.end_row = chunk.first_row + chunk.targets.size();
+            {
+                stats::StageTimer timer(run_stats.search, &pool);
+                trace::Scope scope("search", "first_row", chunk.first_row);
+                Grid chunk_grid(chunk.targets, policy, &chunk.row_locations);
+                target_lons.insert(target_lons.end(), chunk_grid.longitudes().begin(), chunk_grid.longitudes().end());
+                target_lats.insert(target_lats.end(), chunk_grid.latitudes().begin(), chunk_grid.latitudes().end());
+                if (chunk.skip)
+                {
+                    return; // Only its locations are needed, for the target gridlist
+                }
+                const uint64_t searched = static_cast<uint64_t>(chunk_grid.size()) * source_size;
+                if (config_.interp_method == NEAREST_NEIGHBOR || config_.write_mappings)
                 {
-                    writer.write_nn_mappings(nn_mappings);
+                    chunk.nn_mappings = index.find_nearest_neighbors(chunk_grid);
+                    run_stats.distance_evaluations += searched;
                 }
-                if (!idw_mappings.empty())
+                if (config_.interp_method == INVERSE_DISTANCE_WEIGHTED || config_.write_mappings)
                 {
-                    writer.write_idw_mappings(idw_mappings);
+                    chunk.idw_mappings = index.find_idw_neighbors(chunk_grid, chunk.arenas);
+                    const uint64_t fallbacks = count_fallbacks(chunk.idw_mappings);
+                    run_stats.fallbacks += fallbacks;
+                    run_stats.distance_evaluations += searched + fallbacks * source_size;
                 }
             }
-            writer.write_regridded_data(interpolated_points, "regridded.txt", headers);
+            stats::StageTimer timer(run_stats.interpolate, &pool);
+            trace::Scope scope("interpolate", "first_row", chunk.first_row);
+            RegridWeights weights = config_.interp_method == NEAREST_NEIGHBOR
+                                        ? RegridWeights(chunk.nn_mappings, source_size, policy)
+                                        : RegridWeights(chunk.idw_mappings, config_.power, source_size, policy);
+            chunk.results = interpolator.interpolate_rows(chunk.targets, chunk.row_locations, weights);
+            chunk.rows_kept = chunk.results.size();
+        }
+
+        // IDW targets that fell back to Nearest Neighbor. The search evaluates the
+        // distance to every source once per target, and once more per fallback.
+        static uint64_t count_fallbacks(const std::vector<IDWMapping> &mappings)
+        {
+            uint64_t fallbacks = 0;
+            for (const auto &mapping : mappings)
+            {
+                fallbacks += std::get<4>(mapping) ? 1 : 0;
+            }
+            return fallbacks;
+        }
 
+        // Tiled pipeline for target grids too large to hold at once. Target rows
+        // are spooled to disk by tile, and source rows to every tile whose halo
+        // (config.radius) contains them. A target with no source within radius
+        // also gets its nearest source from the whole grid (see far_sources), so
+        // every target is regridded as in an untiled run. Tiles are then regridded
+        // independently, in parallel, each with its own small grid, index and
+        // weights, and the per-tile outputs are concatenated in tile order: rows
+        // are grouped by tile, not in target file order. Memory is bounded by the
+        // tiles in flight and the source locations. Gridlists and mapping files
+        // are not written.
+        void regrid_tiled(const InputReader &source_reader, const InputReader &target_reader,
+                          const std::vector<std::string> &headers, RegridStats &run_stats) const
+        {
             if (config_.verbose)
             {
-                std::cout << "Regridding completed successfully." << std::endl;
+                std::cout << "Tiled mode: spooling rows into " << config_.tile_size << " degree tiles..." << std::endl;
+                if (config_.write_mappings)
+                {
+                    std::cout << "Mapping files are not written in tiled mode" << std::endl;
+                }
+            }
+            TileLayout layout(config_.tile_size, config_);
+            ScratchDirectory scratch(config_.spill_path);
+
+            TileSpool targets(scratch, "target", 0);
+            run_stats.rows_read += target_reader.scan([&](double lon, double lat, int time_step, const ValueType *, size_t)
+                               { targets.append(layout.tile_of(lon, lat), lon, lat, time_step, nullptr); });
+            targets.flush();
+            if (targets.tiles().empty())
+            {
+                throw std::runtime_error("Empty input file: " + targets_[0].target_file);
+            }
+
+            std::unique_ptr<TileSpool> sources;
+            GridStore source_locations(0, buffer_policy(config_));
+            run_stats.rows_read += source_reader.scan([&](double lon, double lat, int time_step, const ValueType *values, size_t count)
+                               {
+                                   if (!sources)
+                                   {
+                                       sources = std::make_unique<TileSpool>(scratch, "source", count);
+                                   }
+                                   const size_t count_so_far = source_locations.size();
+                                   if (count_so_far == 0 || source_locations.longitude(count_so_far - 1) != lon ||
+                                       source_locations.latitude(count_so_far - 1) != lat)
+                                   {
+                                       source_locations.push_back(lon, lat, time_step);
+                                   }
+                                   layout.for_each_halo_tile(lon, lat, [&](size_t tile)
+                                                             {
+                                                                 if (targets.contains(tile))
+                                                                 {
+                                                                     sources->append(tile, lon, lat, time_step, values);
+                                                                 } }); });
+            if (!sources)
+            {
+                throw std::runtime_error("Empty input file: " + source_file_);
+            }
+            run_stats.bytes_read += static_cast<uint64_t>(file_size(source_file_) + file_size(targets_[0].target_file));
+
+            // Nearest sources outside the halo of their targets' tiles, added in a
+            // second pass over the source only if there are any
+            const Grid source_grid(source_locations, buffer_policy(config_));
+            source_locations = GridStore();
+            uint64_t planning_evaluations = 0;
+            const std::unordered_map<size_t, std::vector<size_t>> extra_tiles =
+                far_sources(layout, targets, source_grid, planning_evaluations);
+            run_stats.distance_evaluations += planning_evaluations;
+            std::unordered_set<size_t> reordered;
+            if (!extra_tiles.empty())
+            {
+                run_stats.rows_read += source_reader.scan([&](double lon, double lat, int time_step, const ValueType *values, size_t)
+                                   {
+                                       auto it = extra_tiles.find(source_grid.find(lon, lat));
+                                       if (it != extra_tiles.end())
+                                       {
+                                           for (size_t tile : it->second)
+                                           {
+                                               sources->append(tile, lon, lat, time_step, values);
+                                           }
+                                       } });
+                run_stats.bytes_read += static_cast<uint64_t>(file_size(source_file_));
+                for (const auto &entry : extra_tiles)
+                {
+                    reordered.insert(entry.second.begin(), entry.second.end());
+                }
+            }
+            sources->flush();
+
+            const std::vector<size_t> tiles = targets.tiles();
+            std::vector<std::string> parts;
+            for (size_t tile : tiles)
+            {
+                parts.push_back(scratch.file("regridded_" + std::to_string(tile) + ".txt"));
+            }
+
+            OutputWriter writer(config_);
+            WarningSummary warnings(config_.radius, config_.warning_examples);
+            std::atomic<size_t> rows_written(0);
+            std::atomic<uint64_t> distance_evaluations(0);
+            std::atomic<uint64_t> fallbacks(0);
+            std::atomic<bool> failed(false);
+            pool_for(config_).parallel_for(0, tiles.size(), 1, [&](size_t begin, size_t end)
+                                           {
+                for (size_t i = begin; i < end && !failed; ++i)
+                {
+                    try
+                    {
+                        trace::Scope scope("tile", "tile", tiles[i]);
+                        GridStore tile_sources = sources->read(tiles[i]);
+                        if (reordered.count(tiles[i]) != 0)
+                        {
+                            tile_sources = in_grid_order(tile_sources, source_grid);
+                        }
+                        rows_written += regrid_tile(targets.read(tiles[i]), std::move(tile_sources), writer, parts[i],
+                                                    distance_evaluations, fallbacks, warnings);
+                    }
+                    catch (...)
+                    {
+                        failed = true; // Skip the remaining tiles
+                        throw;
+                    }
+                } });
+            if (rows_written == 0)
+            {
+                throw std::runtime_error(config_.interp_method == NEAREST_NEIGHBOR ? "No points interpolated in NN mode"
+                                                                                   : "No points interpolated in IDW mode");
+            }
+
+            if (config_.verbose)
+            {
+                std::cout << "Writing outputs to: " << config_.output_path << std::endl;
+            }
+            writer.write_regridded_data(parts, "regridded.txt", headers);
+            run_stats.rows_written += rows_written;
+            run_stats.bytes_written += static_cast<uint64_t>(file_size(writer.path("regridded.txt")));
+            run_stats.distance_evaluations += distance_evaluations;
+            run_stats.fallbacks += fallbacks;
+            warnings.report();
+
+            if (config_.verbose)
+            {
+                FastRegridLogger::getInstance().flush(); // Warnings of the run come first
+                std::cout << "Regridding completed successfully (" << tiles.size() << " tiles)." << std::endl;
             }
         }
 
-    private:
+        // Regrids the rows of one tile into part; returns the number of rows written
+        // and adds its search counts to distance_evaluations and fallbacks, and
+        // its warnings to warnings.
+        size_t regrid_tile(const GridStore &target_points, GridStore source_points,
+                           const OutputWriter &writer, const std::string &part,
+                           std::atomic<uint64_t> &distance_evaluations, std::atomic<uint64_t> &fallbacks,
+                           WarningSummary &warnings) const
+        {
+            std::ofstream out(part);
+            if (!out.is_open())
+            {
+                throw std::runtime_error("Cannot open output part: " + part);
+            }
+
+            // Tiles already run in parallel; keep each tile single-threaded
+            RegridConfig tile_config = config_;
+            tile_config.num_threads = 1;
+            tile_config.thread_pool = nullptr;
+            const LargeBufferPolicy policy = buffer_policy(tile_config);
+            auto source_grid = std::make_shared<const Grid>(source_points, policy);
+            Field source_field(source_points, source_grid, policy);
+            source_points = GridStore();
+            std::vector<size_t> target_locations;
+            Grid target_grid(target_points, policy, &target_locations);
+
+            SpatialIndex index(*source_grid, tile_config, &warnings);
+            Arena arena;
+            uint64_t tile_fallbacks = 0;
+            RegridWeights weights = [&]()
+            {
+                if (tile_config.interp_method == NEAREST_NEIGHBOR)
+                {
+                    return RegridWeights(index.find_nearest_neighbors(target_grid), source_grid->size(), policy);
+                }
+                std::vector<IDWMapping> mappings = index.find_idw_neighbors(target_grid, arena);
+                tile_fallbacks = count_fallbacks(mappings);
+                return RegridWeights(mappings, tile_config.power, source_grid->size(), policy);
+            }();
+            distance_evaluations += (target_grid.size() + tile_fallbacks) * source_grid->size();
+            fallbacks += tile_fallbacks;
+            GridStore interpolated_points =
+                Interpolator(source_field, tile_config, &warnings).interpolate_rows(target_points, target_locations, weights);
+            writer.write_rows(out, interpolated_points);
+            if (!out)
+            {
+                throw std::runtime_error("Cannot write output part: " + part);
+            }
+            return interpolated_points.size();
+        }
+
+        // Sources a tile needs beyond its halo. The halo holds every source within
+        // radius of the tile's targets, so only a target with no source within
+        // radius can have its nearest source (Nearest Neighbor, or the IDW
+        // fallback) outside it. Those targets are searched over the whole source
+        // grid. Returns, per location of source_grid, the tiles whose halo lacks it
+        // but which need it. Adds the distances computed to distance_evaluations.
+        std::unordered_map<size_t, std::vector<size_t>> far_sources(TileLayout &layout, const TileSpool &targets,
+                                                                     const Grid &source_grid,
+                                                                     uint64_t &distance_evaluations) const
+        {
+            // Locations within the halo of each target tile, in ascending order
+            std::unordered_map<size_t, std::vector<size_t>> halo;
+            for (size_t s = 0; s < source_grid.size(); ++s)
+            {
+                layout.for_each_halo_tile(source_grid.longitude(s), source_grid.latitude(s), [&](size_t tile)
+                                          {
+                                              if (targets.contains(tile))
+                                              {
+                                                  halo[tile].push_back(s);
+                                              } });
+            }
+
+            RegridConfig search_config = config_;
+            search_config.verbose = false; // The tiles' own searches report warnings
+            const SpatialIndex global_index(source_grid, search_config);
+            std::unordered_map<size_t, std::vector<size_t>> extra_tiles;
+            std::vector<double> halo_lons, halo_lats, far_lons, far_lats;
+            for (size_t tile : targets.tiles())
+            {
+                trace::Scope scope("plan tile", "tile", tile);
+                const Grid target_grid(targets.read(tile));
+                const std::vector<size_t> &local = halo[tile];
+                far_lons.clear();
+                far_lats.clear();
+                if (local.empty())
+                {
+                    far_lons.assign(target_grid.longitudes().begin(), target_grid.longitudes().end());
+                    far_lats.assign(target_grid.latitudes().begin(), target_grid.latitudes().end());
+                }
+                else
+                {
+                    halo_lons.clear();
+                    halo_lats.clear();
+                    for (size_t s : local)
+                    {
+                        halo_lons.push_back(source_grid.longitude(s));
+                        halo_lats.push_back(source_grid.latitude(s));
+                    }
+                    const SpatialIndex halo_index(halo_lons.data(), halo_lats.data(), local.size(), search_config);
+                    for (const NNMapping &mapping : halo_index.find_nearest_neighbors(target_grid))
+                    {
+                        if (std::get<4>(mapping) > config_.radius)
+                        {
+                            far_lons.push_back(std::get<0>(mapping));
+                            far_lats.push_back(std::get<1>(mapping));
+                        }
+                    }
+                    distance_evaluations += target_grid.size() * local.size();
+                }
+                if (far_lons.empty())
+                {
+                    continue;
+                }
+                for (const NNMapping &mapping : global_index.find_nearest_neighbors(far_lons.data(), far_lats.data(), far_lons.size()))
+                {
+                    const size_t s = std::get<6>(mapping);
+                    if (!std::binary_search(local.begin(), local.end(), s))
+                    {
+                        std::vector<size_t> &tiles = extra_tiles[s];
+                        if (tiles.empty() || tiles.back() != tile)
+                        {
+                            tiles.push_back(tile);
+                        }
+                    }
+                }
+                distance_evaluations += far_lons.size() * source_grid.size();
+            }
+            return extra_tiles;
+        }
+
+        // Rows of points in the location order of grid (stable), which is the
+        // order of first appearance in the source file. Extra rows are appended
+        // to a tile after its halo rows; restoring this order lets equidistant
+        // sources break ties as they do in an untiled run.
+        static GridStore in_grid_order(const GridStore &points, const Grid &grid)
+        {
+            std::vector<size_t> location(points.size());
+            for (size_t row = 0; row < points.size(); ++row)
+            {
+                location[row] = grid.find(points.longitude(row), points.latitude(row));
+            }
+            std::vector<size_t> order(points.size());
+            std::iota(order.begin(), order.end(), size_t(0));
+            std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                             { return location[a] < location[b]; });
+            GridStore sorted(points.stride());
+            sorted.reserve(points.size());
+            for (size_t row : order)
+            {
+                sorted.push_back(points.longitude(row), points.latitude(row), points.time_step(row), points.values(row));
+            }
+            return sorted;
+        }
+
         std::string source_file_;
-        std::string target_file_;
+        std::vector<RegridTarget> targets_;
         const RegridConfig &config_;
     };
 
@@ -0,0 +1,157 @@
+/*
+ * session.h
+ * Long-lived regridding session that keeps grids, index and weights in memory in FastRegrid.
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#ifndef FASTREGRID_SESSION_H
+#define FASTREGRID_SESSION_H
+
+#include "config.h"
+#include "types.h"
+#include "grid.h"
+#include "spatial_index.h"
+#include "weights.h"
+#include "thread_pool.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <stdexcept>
+#include <iostream>
+
+namespace fastregrid
+{
+
+    // Regridding between one fixed pair of grids, set up once and applied many
+    // times (e.g. per ensemble member or time step). The session owns a copy of
+    // its config, the unique source and target locations, the spatial index and
+    // the weights; all of them are immutable after construction, so apply() may
+    // be called from any number of threads at once.
+    class RegridSession
+    {
+    public:
+        // Loads the locations of a source and a target file (values are ignored).
+        RegridSession(const std::string &source_file, const std::string &target_file, RegridConfig config)
+            : config_(std::move(config))
+        {
+            if (source_file.empty() || target_file.empty())
+            {
+                throw std::runtime_error("Source or target file path is empty");
+            }
+            if (config_.verbose)
+            {
+                std::cout << "Loading session grids from: " << source_file << ", " << target_file << std::endl;
+            }
+            source_grid_ = Grid::load(source_file, config_);
+            target_grid_ = Grid::load(target_file, config_);
+            build();
+        }
+
+        // From coordinate arrays; duplicate locations are merged as for files.
+        RegridSession(Span<const double> source_lons, Span<const double> source_lats,
+                      Span<const double> target_lons, Span<const double> target_lats, RegridConfig config)
+            : config_(std::move(config))
+        {
+            if (source_lons.size() != source_lats.size() || target_lons.size() != target_lats.size())
+            {
+                throw std::invalid_argument("Longitude and latitude arrays differ in length");
+            }
+            const LargeBufferPolicy policy = buffer_policy(config_);
+            source_grid_ = std::make_shared<const Grid>(source_lons.data(), source_lats.data(), source_lons.size(), policy);
+            target_grid_ = std::make_shared<const Grid>(target_lons.data(), target_lats.data(), target_lons.size(), policy);
+            build();
+        }
+
+        RegridSession(const RegridSession &) = delete;
+        RegridSession &operator=(const RegridSession &) = delete;
+
+        const RegridConfig &config() const { return config_; }
+        const Grid &source_grid() const { return *source_grid_; }
+        const Grid &target_grid() const { return *target_grid_; }
+        const SpatialIndex &index() const { return *index_; }
+        const RegridWeights &weights() const { return weights_; }
+        size_t source_size() const { return source_grid_->size(); }
+        size_t target_size() const { return target_grid_->size(); }
+
+        // Regrids count values per location: value j of source location i is read
+        // from source_values[i * source_stride + j], and the result for target
+        // location t is written to target_values[t * target_stride + j]. Every
+        // target receives a value: IDW targets with fewer than min_points sources
+        // within the radius use their nearest source (weights().fallback(t)).
+        void apply(const ValueType *source_values, size_t source_stride,
+                   ValueType *target_values, size_t target_stride, size_t count) const
+        {
+            if (!source_values || !target_values)
+            {
+                throw std::invalid_argument("Value buffers must not be null");
+            }
+            if (count > source_stride || count > target_stride)
+            {
+                throw std::invalid_argument("Value count exceeds buffer stride");
+            }
+            ThreadPool &pool = pool_for(config_);
+            pool.parallel_for(0, target_size(), pool.grain(target_size(), config_.chunk_size), [&](size_t begin, size_t end)
+                              { weights_.apply(source_values, source_stride, target_values, target_stride,
+                                               count, begin, end); });
+        }
+
+        // One value per source location (in source_grid() order) to one value per
+        // target location (in target_grid() order).
+        std::vector<ValueType> apply(Span<const ValueType> source_values) const
+        {
+            if (source_values.size() != source_size())
+            {
+                throw std::invalid_argument("Expected " + std::to_string(source_size()) + " source values, got " +
+                                            std::to_string(source_values.size()));
+            }
+            std::vector<ValueType> target_values(target_size());
+            apply(source_values.data(), 1, target_values.data(), 1, 1);
+            return target_values;
+        }
+
+    private:
+        void build()
+        {
+            if (source_grid_->size() == 0 || target_grid_->size() == 0)
+            {
+                throw std::runtime_error("Session grids must not be empty");
+            }
+            if (config_.verbose)
+            {
+                std::cout << "Building session weights for " << source_grid_->size() << " source and "
+                          << target_grid_->size() << " target locations..." << std::endl;
+            }
+            const LargeBufferPolicy policy = buffer_policy(config_);
+            index_ = std::make_unique<SpatialIndex>(*source_grid_, config_);
+            if (config_.interp_method == NEAREST_NEIGHBOR)
+            {
+                weights_ = RegridWeights(index_->find_nearest_neighbors(*target_grid_), source_grid_->size(), policy);
+            }
+            else if (config_.interp_method == INVERSE_DISTANCE_WEIGHTED)
+            {
+                ArenaSet arenas(pool_for(config_).size());
+                weights_ = RegridWeights(index_->find_idw_neighbors(*target_grid_, arenas), config_.power,
+                                         source_grid_->size(), policy);
+            }
+            else
+            {
+                throw std::runtime_error("Unknown interpolation method");
+            }
+        }
+
+        RegridConfig config_;
+        std::shared_ptr<const Grid> source_grid_;
+        std::shared_ptr<const Grid> target_grid_;
+        std::unique_ptr<SpatialIndex> index_;
+        RegridWeights weights_;
+    };
+
+} // namespace fastregrid
+
+#endif // FASTREGRID_SESSION_H
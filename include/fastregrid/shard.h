@@ -0,0 +1,188 @@
+/*
+ * shard.h
+ * Multi-process regridding over contiguous target shards and shared mapped weights in FastRegrid.
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#ifndef FASTREGRID_SHARD_H
+#define FASTREGRID_SHARD_H
+
+#include "config.h"
+#include "types.h"
+#include "grid_store.h"
+#include "io.h"
+#include "grid.h"
+#include "weights.h"
+#include "interpolation.h"
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <memory>
+#include <optional>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+namespace fastregrid
+{
+
+    // Splits one regrid across independent processes (e.g. one per NUMA domain,
+    // or scheduler tasks on nodes sharing a file system), using only files:
+    //   1. prepare() once: builds the weights of the whole target grid into
+    //      config.weights_file in config.output_path and writes the gridlists.
+    //   2. run(shard, num_shards) once per shard, in any process: maps the
+    //      weights read-only (processes on one node share their pages), loads
+    //      the source values at the time steps of its rows only and regrids a
+    //      contiguous range of target rows into its own part file.
+    //   3. merge(num_shards) once all shards are done: concatenates the part
+    //      files in shard order into regridded.txt, identical to a single run.
+    // Mapping files are not written.
+    class ShardedRegrid
+    {
+    public:
+        ShardedRegrid(const std::string &source_file, const std::string &target_file, const RegridConfig &config)
+            : source_file_(source_file), target_file_(target_file), config_(config)
+        {
+            if (source_file_.empty() || target_file_.empty())
+            {
+                throw std::runtime_error("Source or target file path is empty");
+            }
+            if (config_.tile_size > 0.0)
+            {
+                throw std::invalid_argument("Sharded runs do not support tiled processing");
+            }
+        }
+
+        // Builds and saves the weights; returns the number of target rows to shard.
+        size_t prepare() const
+        {
+            InputReader source_reader(source_file_, config_);
+            InputReader target_reader(target_file_, config_);
+            validate_headers(source_reader.read_headers(), target_reader.read_headers(), config_);
+
+            auto source_grid = Grid::load(source_file_, config_);
+            size_t stride = 0;
+            GridStore target_points = target_reader.read_locations(stride);
+            Grid target_grid(target_points, buffer_policy(config_));
+            if (config_.verbose)
+            {
+                std::cout << "Building shared weights for " << source_grid->size() << " source and "
+                          << target_grid.size() << " target locations..." << std::endl;
+            }
+            RegridWeights weights = RegridWeights::build(
+                source_grid->longitudes().data(), source_grid->latitudes().data(), source_grid->size(),
+                target_grid.longitudes().data(), target_grid.latitudes().data(), target_grid.size(), config_);
+
+            OutputWriter writer(config_);
+            weights.save(writer.path(config_.weights_file), source_grid->fingerprint(), target_grid.fingerprint(), config_);
+            writer.write_gridlist(source_grid->longitudes(), source_grid->latitudes(), "source_gridlist.txt");
+            writer.write_gridlist(target_grid.longitudes(), target_grid.latitudes(), "target_gridlist.txt");
+            return target_points.size();
+        }
+
+        // Regrids target rows [rows * shard / num_shards, rows * (shard + 1) / num_shards)
+        // into part_file(shard, num_shards); returns the number of rows written.
+        size_t run(size_t shard, size_t num_shards) const
+        {
+            if (num_shards == 0 || shard >= num_shards)
+            {
+                throw std::invalid_argument("Shard " + std::to_string(shard) + " out of range for " +
+                                            std::to_string(num_shards) + " shards");
+            }
+            const LargeBufferPolicy policy = buffer_policy(config_);
+            InputReader target_reader(target_file_, config_);
+            size_t stride = 0;
+            GridStore target_points = target_reader.read_locations(stride);
+            std::vector<size_t> row_locations;
+            Grid target_grid(target_points, policy, &row_locations);
+
+            const size_t rows = target_points.size();
+            const size_t first = rows * shard / num_shards;
+            const size_t last = rows * (shard + 1) / num_shards;
+            GridStore shard_points(0, policy);
+            shard_points.reserve(last - first);
+            std::unordered_set<int> needed;
+            for (size_t row = first; row < last; ++row)
+            {
+                shard_points.push_back(target_points.longitude(row), target_points.latitude(row),
+                                       target_points.time_step(row));
+                needed.insert(target_points.time_step(row));
+            }
+            std::vector<size_t> shard_locations(row_locations.begin() + first, row_locations.begin() + last);
+            target_points = GridStore();
+
+            // Only the shard's time steps are kept, so N shards hold about one copy of
+            // the source values between them rather than N
+            Field source_field = Field::load(source_file_, config_, needed);
+            OutputWriter writer(config_);
+            const std::string weights_file = writer.path(config_.weights_file);
+            std::optional<RegridWeights> weights =
+                RegridWeights::map(weights_file, source_field.grid().fingerprint(), target_grid.fingerprint(), config_);
+            if (!weights)
+            {
+                throw std::runtime_error("No weights for these grids and settings in " + weights_file +
+                                         "; run prepare() first");
+            }
+            if (config_.verbose)
+            {
+                std::cout << "Shard " << shard + 1 << " of " << num_shards << ": target rows " << first << " to "
+                          << last << std::endl;
+            }
+
+            GridStore interpolated_points =
+                Interpolator(source_field, config_).interpolate_rows(shard_points, shard_locations, *weights);
+            const std::string part = writer.path(part_file(shard, num_shards));
+            std::ofstream file(part);
+            if (!file.is_open())
+            {
+                throw std::runtime_error("Cannot open output file: " + part);
+            }
+            writer.write_rows(file, interpolated_points);
+            file.close();
+            if (!file)
+            {
+                throw std::runtime_error("Cannot write outputs to: " + part);
+            }
+            return interpolated_points.size();
+        }
+
+        // Concatenates the part files of all shards into regridded.txt and removes them.
+        void merge(size_t num_shards) const
+        {
+            OutputWriter writer(config_);
+            std::vector<std::string> parts;
+            for (size_t shard = 0; shard < num_shards; ++shard)
+            {
+                parts.push_back(writer.path(part_file(shard, num_shards)));
+            }
+            writer.write_regridded_data(parts, "regridded.txt", InputReader(source_file_, config_).read_headers());
+            for (const auto &part : parts)
+            {
+                std::remove(part.c_str());
+            }
+            if (config_.verbose)
+            {
+                std::cout << "Merged " << num_shards << " shards into: " << writer.path("regridded.txt") << std::endl;
+            }
+        }
+
+        // Name of the part file of a shard within the output directory.
+        static std::string part_file(size_t shard, size_t num_shards)
+        {
+            return "regridded.part" + std::to_string(shard) + "of" + std::to_string(num_shards) + ".txt";
+        }
+
+    private:
+        std::string source_file_;
+        std::string target_file_;
+        const RegridConfig &config_;
+    };
+
+} // namespace fastregrid
+
+#endif // FASTREGRID_SHARD_H
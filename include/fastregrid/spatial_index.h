@@ -14,11 +14,22 @@
 
 #include "config.h"
 #include "types.h"
+#include "grid_store.h"
+#include "grid.h"
 #include "utils.h"
+#include "neighbor_list.h"
+#include "arena.h"
+#include "thread_pool.h"
+#include "logger.h"
+#include "warnings.h"
+#include "trace.h"
 #include <vector>
 #include <algorithm>
 #include <stdexcept>
 #include <iostream>
+#include <tuple>
+#include <limits>
+#include <memory_resource>
 
 namespace fastregrid
 {
@@ -26,159 +37,254 @@ namespace fastregrid
     class SpatialIndex
     {
     public:
-        explicit SpatialIndex(const std::vector<SpatialData> &source_points, const RegridConfig &config)
-            : source_points_(source_points), config_(config)
+        // Indexes count source locations given as coordinate arrays (not copied).
+        // Warnings are tallied into warnings if given (e.g. one summary for a
+        // whole run), else into the index's own summary.
+        SpatialIndex(const double *source_lons, const double *source_lats, size_t count, const RegridConfig &config,
+                     WarningSummary *warnings = nullptr)
+            : source_lons_(source_lons), source_lats_(source_lats), source_count_(count), config_(config),
+              own_warnings_(config.radius, config.warning_examples), warnings_(warnings ? warnings : &own_warnings_)
         {
-            if (source_points_.empty())
+            if (source_count_ == 0)
             {
                 throw std::runtime_error("Source point list is empty");
             }
         }
 
+        explicit SpatialIndex(const Grid &source_grid, const RegridConfig &config, WarningSummary *warnings = nullptr)
+            : SpatialIndex(source_grid.longitudes().data(), source_grid.latitudes().data(), source_grid.size(), config,
+                           warnings)
+        {
+        }
+
+        explicit SpatialIndex(const GridStore &source_points, const RegridConfig &config,
+                              WarningSummary *warnings = nullptr)
+            : SpatialIndex(source_points.longitudes().data(), source_points.latitudes().data(), source_points.size(),
+                           config, warnings)
+        {
+        }
+
+        // Summary of the warnings of this index's searches (with config.verbose).
+        WarningSummary &warnings() const { return *warnings_; }
+
         // Finds nearest neighbor for each target point.
-        std::vector<std::tuple<double, double, double, double, double, size_t>> find_nearest_neighbors(
-            const std::vector<SpatialData> &target_points) const
+        std::vector<NNMapping> find_nearest_neighbors(const GridStore &target_points) const
         {
-            std::vector<std::tuple<double, double, double, double, double, size_t>> mappings;
-            mappings.reserve(target_points.size());
+            return find_nearest_neighbors(target_points.longitudes().data(), target_points.latitudes().data(), target_points.size());
+        }
 
-            for (size_t t_idx = 0; t_idx < target_points.size(); ++t_idx)
-            {
-                const auto &target = target_points[t_idx];
-                double min_distance = std::numeric_limits<double>::max();
-                double source_lon = 0.0, source_lat = 0.0;
+        // Finds nearest neighbor for each target grid location.
+        std::vector<NNMapping> find_nearest_neighbors(const Grid &target_grid) const
+        {
+            return find_nearest_neighbors(target_grid.longitudes().data(), target_grid.latitudes().data(), target_grid.size());
+        }
 
-                for (const auto &source : source_points_)
+        // Finds nearest neighbor for each of count target coordinates, in chunks
+        // of at most config.chunk_size targets (see ThreadPool::grain) on the
+        // run's thread pool.
+        std::vector<NNMapping> find_nearest_neighbors(const double *target_lons, const double *target_lats, size_t count) const
+        {
+            std::vector<NNMapping> mappings(count);
+            ThreadPool &pool = pool_for(config_);
+            pool.parallel_for(0, count, pool.grain(count, config_.chunk_size), [&](size_t begin, size_t end)
+                              {
+                trace::Scope scope("nearest task", "first_target", begin);
+                WarningTallies tallies;
+                for (size_t t_idx = begin; t_idx < end; ++t_idx)
                 {
-                    double distance = utils::compute_distance(
-                        target.gridPoint.longitude, target.gridPoint.latitude,
-                        source.gridPoint.longitude, source.gridPoint.latitude,
-                        config_.distance_metric);
-                    if (distance < min_distance)
+                    const double target_lon = target_lons[t_idx];
+                    const double target_lat = target_lats[t_idx];
+                    size_t s_nearest = 0;
+                    double min_distance = nearest(target_lon, target_lat, s_nearest);
+
+                    if (min_distance == std::numeric_limits<double>::max())
                     {
-                        min_distance = distance;
-                        source_lon = source.gridPoint.longitude;
-                        source_lat = source.gridPoint.latitude;
+                        throw std::runtime_error("No valid source points found for target (" +
+                                                 std::to_string(target_lon) + ", " +
+                                                 std::to_string(target_lat) + ")");
                     }
-                }
 
-                if (min_distance == std::numeric_limits<double>::max())
-                {
-                    throw std::runtime_error("No valid source points found for target (" +
-                                             std::to_string(target.gridPoint.longitude) + ", " +
-                                             std::to_string(target.gridPoint.latitude) + ")");
+                    double dist_km = config_.distance_metric == HAVERSINE
+                                         ? min_distance
+                                         : min_distance * 111.32 * std::cos(utils::to_radians(target_lat));
+
+                    if (config_.verbose && dist_km > config_.radius)
+                    {
+                        tallies[WARNING_NEAREST_BEYOND_RADIUS].add(target_lon, target_lat, dist_km, config_.radius);
+                        if (warnings_->example(WARNING_NEAREST_BEYOND_RADIUS))
+                        {
+                            log_warning("Nearest source point for target ({}, {}) is at distance {} km, exceeding radius {} km",
+                                        target_lon, target_lat, dist_km, config_.radius);
+                        }
+                    }
+
+                    mappings[t_idx] = NNMapping(target_lon, target_lat,
+                                                source_lons_[s_nearest], source_lats_[s_nearest], dist_km, t_idx, s_nearest);
                 }
+                warnings_->merge(tallies); });
+
+            return mappings;
+        }
+
+        // Finds up to max_points neighbors within radius for IDW, with fallback to Nearest Neighbor.
+        // Neighbour lists are allocated from arena (typically the per-run or per-tile
+        // Arena), which must outlive the mappings; there is no heap-allocating form.
+        std::vector<IDWMapping> find_idw_neighbors(const GridStore &target_points, Arena &arena) const
+        {
+            return find_idw_neighbors(target_points.longitudes().data(), target_points.latitudes().data(),
+                                      target_points.size(), arena);
+        }
+
+        std::vector<IDWMapping> find_idw_neighbors(const Grid &target_grid, Arena &arena) const
+        {
+            return find_idw_neighbors(target_grid.longitudes().data(), target_grid.latitudes().data(),
+                                      target_grid.size(), arena);
+        }
+
+        std::vector<IDWMapping> find_idw_neighbors(const double *target_lons, const double *target_lats, size_t count,
+                                                   Arena &arena) const
+        {
+            return dispatch_neighbor_list(config_.max_points, [&](auto &candidates)
+                                          {
+                std::vector<IDWMapping> mappings;
+                mappings.reserve(count);
+                find_idw_neighbors_impl(target_lons, target_lats, 0, count, arena.resource(), candidates, mappings);
+                return mappings; });
+        }
 
-                double dist_km = config_.distance_metric == HAVERSINE
-                                     ? min_distance
-                                     : min_distance * 111.32 * std::cos(utils::to_radians(target.gridPoint.latitude));
+        // Parallel form: chunks of at most config.chunk_size targets (see
+        // ThreadPool::grain) run on the run's thread pool, each allocating neighbour lists from its worker's arena.
+        std::vector<IDWMapping>
+        find_idw_neighbors(const Grid &target_grid, ArenaSet &arenas) const
+        {
+            return find_idw_neighbors(target_grid.longitudes().data(), target_grid.latitudes().data(),
+                                      target_grid.size(), arenas);
+        }
 
-                if (config_.verbose && dist_km > config_.radius)
+        std::vector<IDWMapping>
+        find_idw_neighbors(const double *target_lons, const double *target_lats, size_t count, ArenaSet &arenas) const
+        {
+            ThreadPool &pool = pool_for(config_);
+            if (arenas.size() < pool.size())
+            {
+                throw std::invalid_argument("ArenaSet needs one arena per pool thread");
+            }
+            return dispatch_neighbor_list(config_.max_points, [&](auto &candidates)
+                                          {
+                const size_t chunk = pool.grain(count, config_.chunk_size);
+                std::vector<std::vector<IDWMapping>> chunks((count + chunk - 1) / chunk);
+                pool.parallel_for(0, count, chunk, [&](size_t begin, size_t end)
+                                  {
+                    trace::Scope scope("idw task", "first_target", begin);
+                    auto local_candidates = candidates;
+                    std::vector<IDWMapping> &part = chunks[begin / chunk];
+                    part.reserve(end - begin);
+                    find_idw_neighbors_impl(target_lons, target_lats, begin, end,
+                                            arenas.local(pool.slot()).resource(), local_candidates, part); });
+                // Move construction keeps each neighbour list on its arena
+                std::vector<IDWMapping> mappings;
+                mappings.reserve(count);
+                for (auto &part : chunks)
                 {
-                    std::cerr << "Warning: Nearest source point for target (" << target.gridPoint.longitude << ", " << target.gridPoint.latitude
-                              << ") is at distance " << dist_km << " km, exceeding radius " << config_.radius << " km"
-                              << std::endl;
+                    for (auto &mapping : part)
+                    {
+                        mappings.emplace_back(std::move(mapping));
+                    }
                 }
+                return mappings; });
+        }
 
-                mappings.emplace_back(target.gridPoint.longitude, target.gridPoint.latitude,
-                                      source_lon, source_lat, dist_km, t_idx);
+    private:
+        // Returns the distance (in metric units) to the nearest source and stores its index.
+        double nearest(double target_lon, double target_lat, size_t &source_index) const
+        {
+            double min_distance = std::numeric_limits<double>::max();
+            for (size_t s_idx = 0; s_idx < source_count_; ++s_idx)
+            {
+                double distance = utils::compute_distance(
+                    target_lon, target_lat,
+                    source_lons_[s_idx], source_lats_[s_idx],
+                    config_.distance_metric);
+                if (distance < min_distance)
+                {
+                    min_distance = distance;
+                    source_index = s_idx;
+                }
             }
-
-            return mappings;
+            return min_distance;
         }
 
-        // Finds up to max_points neighbors within radius for IDW, with fallback to Nearest Neighbor.
-        std::vector<std::tuple<double, double, std::vector<std::tuple<double, double, double>>, size_t, bool>>
-        find_idw_neighbors(const std::vector<SpatialData> &target_points) const
+        // IDW search of targets [begin, end) for one neighbour list type, appending
+        // to mappings; candidates is reused across targets.
+        template <typename NeighborList>
+        void find_idw_neighbors_impl(const double *target_lons, const double *target_lats, size_t begin, size_t end,
+                                     std::pmr::memory_resource *resource, NeighborList &candidates,
+                                     std::vector<IDWMapping> &mappings) const
         {
-            std::vector<std::tuple<double, double, std::vector<std::tuple<double, double, double>>, size_t, bool>> mappings;
-            mappings.reserve(target_points.size());
+            const double *source_lons = source_lons_;
+            const double *source_lats = source_lats_;
+            WarningTallies tallies;
 
-            for (size_t t_idx = 0; t_idx < target_points.size(); ++t_idx)
+            for (size_t t_idx = begin; t_idx < end; ++t_idx)
             {
-                const auto &target = target_points[t_idx];
-                std::vector<std::tuple<double, double, double>> neighbors; // (source_lon, source_lat, distance)
+                const double target_lon = target_lons[t_idx];
+                const double target_lat = target_lats[t_idx];
+                const double radius = config_.distance_metric == EUCLIDEAN
+                                          ? utils::km_to_degrees(config_.radius, target_lat)
+                                          : config_.radius;
+                candidates.clear();
+                IDWNeighbors neighbors(resource); // (source_lon, source_lat, distance)
 
-                // Compute distances to all source points
-                for (const auto &source : source_points_)
+                // Keep the max_points nearest source points within radius
+                for (size_t s_idx = 0; s_idx < source_count_; ++s_idx)
                 {
                     double distance = utils::compute_distance(
-                        target.gridPoint.longitude, target.gridPoint.latitude,
-                        source.gridPoint.longitude, source.gridPoint.latitude,
+                        target_lon, target_lat,
+                        source_lons[s_idx], source_lats[s_idx],
                         config_.distance_metric);
-                    if (config_.distance_metric == EUCLIDEAN)
+                    if (distance <= radius)
                     {
-                        double radius_deg = utils::km_to_degrees(config_.radius, target.gridPoint.latitude);
-                        if (distance <= radius_deg)
-                        {
-                            neighbors.emplace_back(source.gridPoint.longitude, source.gridPoint.latitude, distance);
-                        }
-                    }
-                    else
-                    {
-                        if (distance <= config_.radius)
-                        {
-                            neighbors.emplace_back(source.gridPoint.longitude, source.gridPoint.latitude, distance);
-                        }
+                        candidates.offer(source_lons[s_idx], source_lats[s_idx], distance, s_idx);
                     }
                 }
 
                 bool is_fallback = false;
-                if (neighbors.size() < static_cast<size_t>(config_.min_points))
+                if (candidates.offered() < static_cast<size_t>(config_.min_points))
                 {
                     // Fallback to Nearest Neighbor
-                    if (config_.verbose)
+                    if (config_.verbose && warnings_->example(WARNING_IDW_FALLBACK))
                     {
-                        std::cerr << "Warning: Only " << neighbors.size() << " points found within radius "
-                                  << config_.radius << " km for target (" << target.gridPoint.longitude << ", " << target.gridPoint.latitude
-                                  << "); falling back to Nearest Neighbor (min_points = " << config_.min_points << ")"
-                                  << std::endl;
+                        log_warning("Only {} points found within radius {} km for target ({}, {}); "
+                                    "falling back to Nearest Neighbor (min_points = {})",
+                                    candidates.offered(), config_.radius, target_lon, target_lat, config_.min_points);
                     }
                     is_fallback = true;
-                    neighbors.clear();
-                    double min_distance = std::numeric_limits<double>::max();
-                    double source_lon = 0.0, source_lat = 0.0;
-
-                    for (const auto &source : source_points_)
-                    {
-                        double distance = utils::compute_distance(
-                            target.gridPoint.longitude, target.gridPoint.latitude,
-                            source.gridPoint.longitude, source.gridPoint.latitude,
-                            config_.distance_metric);
-                        if (distance < min_distance)
-                        {
-                            min_distance = distance;
-                            source_lon = source.gridPoint.longitude;
-                            source_lat = source.gridPoint.latitude;
-                        }
-                    }
+                    size_t s_nearest = 0;
+                    double min_distance = nearest(target_lon, target_lat, s_nearest);
 
                     if (min_distance != std::numeric_limits<double>::max())
                     {
                         double dist_km = config_.distance_metric == HAVERSINE
                                              ? min_distance
-                                             : min_distance * 111.32 * std::cos(utils::to_radians(target.gridPoint.latitude));
-                        neighbors.emplace_back(source_lon, source_lat, dist_km);
+                                             : min_distance * 111.32 * std::cos(utils::to_radians(target_lat));
+                        if (config_.verbose)
+                        {
+                            tallies[WARNING_IDW_FALLBACK].add(target_lon, target_lat, dist_km, config_.radius);
+                        }
+                        neighbors.reserve(1);
+                        neighbors.emplace_back(source_lons_[s_nearest], source_lats_[s_nearest], dist_km, s_nearest);
                     }
                 }
                 else
                 {
-                    // Sort by distance and take up to max_points
-                    std::sort(neighbors.begin(), neighbors.end(),
-                              [](const auto &a, const auto &b)
-                              {
-                                  return std::get<2>(a) < std::get<2>(b);
-                              });
-                    if (neighbors.size() > static_cast<size_t>(config_.max_points))
-                    {
-                        neighbors.resize(config_.max_points);
-                    }
+                    // Candidates are already sorted by distance and capped at max_points
+                    neighbors.assign(candidates.begin(), candidates.end());
                     // Convert Euclidean distances to km if needed
                     if (config_.distance_metric == EUCLIDEAN)
                     {
                         for (auto &neighbor : neighbors)
                         {
-                            std::get<2>(neighbor) = std::get<2>(neighbor) * 111.32 * std::cos(utils::to_radians(target.gridPoint.latitude));
+                            std::get<2>(neighbor) = std::get<2>(neighbor) * 111.32 * std::cos(utils::to_radians(target_lat));
                         }
                     }
                 }
@@ -186,20 +292,22 @@ namespace fastregrid
                 if (neighbors.empty())
                 {
                     throw std::runtime_error("No valid source points found for target (" +
-                                             std::to_string(target.gridPoint.longitude) + ", " +
-                                             std::to_string(target.gridPoint.latitude) + ")");
+                                             std::to_string(target_lon) + ", " +
+                                             std::to_string(target_lat) + ")");
                 }
 
-                mappings.emplace_back(target.gridPoint.longitude, target.gridPoint.latitude,
+                mappings.emplace_back(target_lon, target_lat,
                                       std::move(neighbors), t_idx, is_fallback);
             }
-
-            return mappings;
+            warnings_->merge(tallies);
         }
 
-    private:
-        const std::vector<SpatialData> &source_points_;
+        const double *source_lons_;
+        const double *source_lats_;
+        size_t source_count_;
         const RegridConfig &config_;
+        WarningSummary own_warnings_;
+        WarningSummary *warnings_;
     };
 
 } // namespace fastregrid
@@ -0,0 +1,280 @@
+/*
+ * stats.h
+ * Per-stage timings and I/O counters of regrid runs in FastRegrid.
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#ifndef FASTREGRID_STATS_H
+#define FASTREGRID_STATS_H
+
+#include "thread_pool.h"
+#include "trace.h"
+#include "perf_counters.h"
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <chrono>
+#include <iterator>
+#include <utility>
+#include <stdexcept>
+#include <cstdint>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef NOGDI
+#define NOGDI // wingdi.h defines ERROR, a FastRegridLogger level
+#endif
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+namespace fastregrid
+{
+
+    // Wall and CPU seconds spent in one stage, and its hardware counters if
+    // they were read (config.hardware_counters).
+    struct StageTimes
+    {
+        double wall_seconds = 0.0;
+        double cpu_seconds = 0.0;
+        HardwareCounters counters;
+    };
+
+    // What a regrid run did and what it cost. Stages of the streaming pipeline
+    // run concurrently, so their wall times overlap and may add up to more than
+    // total; waits on the queues between stages count towards neither the wall
+    // nor the CPU time of a stage (only towards total). In tiled mode only
+    // total and the counters are filled in.
+    struct RegridStats
+    {
+        StageTimes read_source; // Source rows parsed into the grid and field
+        StageTimes parse;       // Target rows parsed into chunks
+        StageTimes search;      // Neighbour search over the chunk's locations
+        StageTimes interpolate; // Weights and interpolated rows
+        StageTimes format;      // Rows and mappings formatted as text
+        StageTimes write;       // Text written to the output files
+        StageTimes total;       // Whole run; CPU over all threads of the process, counters summed over the stages
+
+        uint64_t rows_read = 0;            // Source and target rows
+        uint64_t bytes_read = 0;           // Bytes of input parsed (files parsed twice count twice)
+        uint64_t rows_written = 0;         // Rows of regridded data
+        uint64_t bytes_written = 0;        // Bytes of all output files, gridlists included
+        uint64_t distance_evaluations = 0; // Source-target distances computed by the neighbour search
+        uint64_t fallbacks = 0;            // IDW targets that fell back to Nearest Neighbor
+        uint64_t peak_memory_bytes = 0;    // Peak resident set size of the process (0 if unavailable)
+        bool hardware_counters = false;    // Stage counters were read
+
+        std::string to_json() const
+        {
+            std::ostringstream out;
+            out.precision(6);
+            out << std::fixed << "{\n  \"stages\": {\n";
+            const std::pair<const char *, const StageTimes *> stages[] = {
+                {"read_source", &read_source}, {"parse", &parse}, {"search", &search},
+                {"interpolate", &interpolate}, {"format", &format}, {"write", &write}, {"total", &total}};
+            for (size_t i = 0; i < std::size(stages); ++i)
+            {
+                const StageTimes &stage = *stages[i].second;
+                out << "    \"" << stages[i].first << "\": {\"wall_seconds\": " << stage.wall_seconds
+                    << ", \"cpu_seconds\": " << stage.cpu_seconds;
+                if (hardware_counters)
+                {
+                    out << ", \"cycles\": " << stage.counters.cycles << ", \"instructions\": " << stage.counters.instructions
+                        << ", \"ipc\": " << stage.counters.ipc() << ", \"cache_misses\": " << stage.counters.cache_misses
+                        << ", \"branch_misses\": " << stage.counters.branch_misses;
+                }
+                out << "}" << (i + 1 < std::size(stages) ? ",\n" : "\n");
+            }
+            out << "  },\n"
+                << "  \"rows_read\": " << rows_read << ",\n"
+                << "  \"bytes_read\": " << bytes_read << ",\n"
+                << "  \"rows_written\": " << rows_written << ",\n"
+                << "  \"bytes_written\": " << bytes_written << ",\n"
+                << "  \"distance_evaluations\": " << distance_evaluations << ",\n"
+                << "  \"fallbacks\": " << fallbacks << ",\n"
+                << "  \"peak_memory_bytes\": " << peak_memory_bytes << ",\n"
+                << "  \"hardware_counters\": " << (hardware_counters ? "true" : "false") << "\n"
+                << "}\n";
+            return out.str();
+        }
+
+        void write_json(const std::string &filename) const
+        {
+            std::ofstream file(filename);
+            if (!file.is_open())
+            {
+                throw std::runtime_error("Cannot open stats file: " + filename);
+            }
+            file << to_json();
+            if (!file)
+            {
+                throw std::runtime_error("Cannot write stats file: " + filename);
+            }
+        }
+    };
+
+    namespace stats
+    {
+
+        // CPU seconds used so far by the calling thread.
+        inline double thread_cpu_seconds()
+        {
+#ifdef _WIN32
+            FILETIME created, exited, kernel, user;
+            if (!GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &user))
+            {
+                return 0.0;
+            }
+            auto seconds = [](const FILETIME &time)
+            { return static_cast<double>((static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime) * 1e-7; };
+            return seconds(kernel) + seconds(user);
+#else
+            timespec now;
+            if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) != 0)
+            {
+                return 0.0;
+            }
+            return static_cast<double>(now.tv_sec) + static_cast<double>(now.tv_nsec) * 1e-9;
+#endif
+        }
+
+        // CPU seconds used so far by all threads of the process.
+        inline double process_cpu_seconds()
+        {
+#ifdef _WIN32
+            FILETIME created, exited, kernel, user;
+            if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user))
+            {
+                return 0.0;
+            }
+            auto seconds = [](const FILETIME &time)
+            { return static_cast<double>((static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime) * 1e-7; };
+            return seconds(kernel) + seconds(user);
+#else
+            timespec now;
+            if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now) != 0)
+            {
+                return 0.0;
+            }
+            return static_cast<double>(now.tv_sec) + static_cast<double>(now.tv_nsec) * 1e-9;
+#endif
+        }
+
+        // Peak resident set size of the process in bytes, or 0 if unknown.
+        inline uint64_t peak_memory_bytes()
+        {
+#ifdef _WIN32
+            return 0;
+#else
+            rusage usage;
+            if (getrusage(RUSAGE_SELF, &usage) != 0)
+            {
+                return 0;
+            }
+#ifdef __APPLE__
+            return static_cast<uint64_t>(usage.ru_maxrss); // Bytes on macOS
+#else
+            return static_cast<uint64_t>(usage.ru_maxrss) * 1024; // Kilobytes elsewhere
+#endif
+#endif
+        }
+
+        // Adds the time from construction to destruction to times: wall time and
+        // CPU time (and hardware counters while perf::enabled()) of the calling
+        // thread, plus those of pool's workers if given (for stages that hand
+        // work to the pool). Waits on other stages can be left out by running
+        // them through idle(), which excludes both their wall time and the CPU
+        // time the waiting thread spends spinning or yielding.
+        class StageTimer
+        {
+        public:
+            explicit StageTimer(StageTimes &times, ThreadPool *pool = nullptr)
+                : times_(times), pool_(pool), counting_(perf::enabled()), wall_start_(Clock::now()),
+                  cpu_start_(cpu_seconds()), counters_start_(counters())
+            {
+            }
+
+            StageTimer(const StageTimer &) = delete;
+            StageTimer &operator=(const StageTimer &) = delete;
+
+            ~StageTimer()
+            {
+                times_.wall_seconds += seconds_since(wall_start_) - idle_seconds_;
+                times_.cpu_seconds += cpu_seconds() - cpu_start_ - idle_cpu_seconds_;
+                if (counting_)
+                {
+                    times_.counters += counters() - counters_start_;
+                }
+            }
+
+            // Runs fn (e.g. a blocking queue push or pop) without counting its wall
+            // or CPU time; traced as a "wait" span.
+            template <typename Fn>
+            decltype(auto) idle(Fn &&fn)
+            {
+                trace::Scope scope("wait");
+                struct Resume
+                {
+                    StageTimer &timer;
+                    Clock::time_point start;
+                    double cpu_start;
+                    ~Resume()
+                    {
+                        timer.idle_seconds_ += seconds_since(start);
+                        timer.idle_cpu_seconds_ += thread_cpu_seconds() - cpu_start;
+                    }
+                } resume{*this, Clock::now(), thread_cpu_seconds()};
+                return fn();
+            }
+
+        private:
+            using Clock = std::chrono::steady_clock;
+
+            static double seconds_since(Clock::time_point start)
+            {
+                return std::chrono::duration<double>(Clock::now() - start).count();
+            }
+
+            double cpu_seconds() const
+            {
+                return thread_cpu_seconds() + (pool_ ? pool_->cpu_seconds() : 0.0);
+            }
+
+            HardwareCounters counters() const
+            {
+                HardwareCounters counters;
+                if (counting_)
+                {
+                    counters = perf::thread_counters();
+                    if (pool_)
+                    {
+                        counters += pool_->hardware_counters();
+                    }
+                }
+                return counters;
+            }
+
+            StageTimes &times_;
+            ThreadPool *pool_;
+            bool counting_;
+            Clock::time_point wall_start_;
+            double cpu_start_;
+            HardwareCounters counters_start_;
+            double idle_seconds_ = 0.0;
+            double idle_cpu_seconds_ = 0.0;
+        };
+
+    } // namespace stats
+
+} // namespace fastregrid
+
+#endif // FASTREGRID_STATS_H
@@ -0,0 +1,363 @@
+/*
+ * thread_pool.h
+ * Shared work-stealing thread pool used by the parallel stages of FastRegrid.
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#ifndef FASTREGRID_THREAD_POOL_H
+#define FASTREGRID_THREAD_POOL_H
+
+#include "config.h"
+#include "utils.h"
+#include "trace.h"
+#include "perf_counters.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <time.h>
+#endif
+
+namespace fastregrid
+{
+
+    // Fixed set of worker threads, each with its own task deque. Work is
+    // submitted as chunked ranges (parallel_for); every worker is seeded with a
+    // contiguous run of chunks, takes from the back of its own deque and, when
+    // idle, steals from the front of the others', so uneven chunks balance out.
+    //
+    // A pool of size 1 has no threads and runs everything on the caller. A pool
+    // of size n > 1 runs n workers; callers outside the pool block until their
+    // range is done, while a worker that calls parallel_for (nested) helps.
+    class ThreadPool
+    {
+    public:
+        explicit ThreadPool(size_t num_threads)
+            : queues_(std::max<size_t>(1, num_threads)), worker_ids_(queues_.size())
+        {
+            if (queues_.size() > 1)
+            {
+                workers_.reserve(queues_.size());
+                for (size_t slot = 0; slot < queues_.size(); ++slot)
+                {
+                    workers_.emplace_back([this, slot]()
+                                          { run(slot); });
+                }
+            }
+        }
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(sleep_mutex_);
+                stop_ = true;
+            }
+            wake_.notify_all();
+            for (auto &worker : workers_)
+            {
+                worker.join();
+            }
+        }
+
+        // Number of threads running tasks (and of per-worker slots).
+        size_t size() const { return queues_.size(); }
+
+        // CPU seconds used so far by the pool's worker threads (0 for a pool of
+        // size 1, whose work runs on the caller, and on platforms other than Linux).
+        double cpu_seconds()
+        {
+            double seconds = 0.0;
+#if defined(__linux__)
+            for (auto &worker : workers_)
+            {
+                clockid_t clock;
+                timespec now;
+                if (pthread_getcpuclockid(worker.native_handle(), &clock) == 0 && clock_gettime(clock, &now) == 0)
+                {
+                    seconds += static_cast<double>(now.tv_sec) + static_cast<double>(now.tv_nsec) * 1e-9;
+                }
+            }
+#endif
+            return seconds;
+        }
+
+        // Hardware counters of the pool's worker threads since they were first
+        // read (zeros for a pool of size 1 or where counters are unavailable).
+        HardwareCounters hardware_counters()
+        {
+            HardwareCounters counters;
+            std::lock_guard<std::mutex> lock(counters_mutex_);
+            if (worker_counters_.size() < workers_.size())
+            {
+                worker_counters_.resize(workers_.size());
+            }
+            for (size_t slot = 0; slot < workers_.size(); ++slot)
+            {
+                auto &group = worker_counters_[slot];
+                const long id = worker_ids_[slot].load(std::memory_order_acquire);
+                if (!group && id != 0)
+                {
+                    group = std::make_unique<perf::CounterGroup>(id);
+                }
+                if (group)
+                {
+                    counters += group->read();
+                }
+            }
+            return counters;
+        }
+
+        // Slot of the calling thread in [0, size()): its worker index, or 0
+        // outside the pool. Tasks of one parallel_for never share a slot, so it
+        // can index per-worker state such as an ArenaSet.
+        size_t slot() const
+        {
+            return current_pool() == this ? current_slot() : 0;
+        }
+
+        // Items per parallel_for chunk for count items: about four chunks per
+        // thread, so the pool stays busy and balanced even when count is a single
+        // pipeline chunk, but at most max_grain items (e.g. config.chunk_size).
+        size_t grain(size_t count, size_t max_grain) const
+        {
+            const size_t tasks = size() * 4;
+            return std::max<size_t>(1, std::min(std::max<size_t>(1, max_grain), (count + tasks - 1) / tasks));
+        }
+
+        // Calls fn(chunk_begin, chunk_end) for consecutive chunks of [begin, end)
+        // of at most chunk items, and returns when all are done. The first
+        // exception thrown by fn is rethrown here (remaining chunks still run).
+        template <typename Fn>
+        void parallel_for(size_t begin, size_t end, size_t chunk, Fn &&fn)
+        {
+            if (begin >= end)
+            {
+                return;
+            }
+            chunk = std::max<size_t>(1, chunk);
+            const size_t chunks = (end - begin + chunk - 1) / chunk;
+            if (workers_.empty() || chunks == 1)
+            {
+                for (size_t b = begin; b < end; b += chunk)
+                {
+                    fn(b, std::min(end, b + chunk));
+                }
+                return;
+            }
+
+            Job job;
+            job.fn = const_cast<void *>(static_cast<const void *>(std::addressof(fn)));
+            job.call = [](void *f, size_t b, size_t e)
+            { (*static_cast<std::remove_reference_t<Fn> *>(f))(b, e); };
+            job.remaining.store(chunks, std::memory_order_relaxed);
+
+            const size_t n = queues_.size();
+            for (size_t q = 0; q < n; ++q)
+            {
+                std::lock_guard<std::mutex> lock(queues_[q].mutex);
+                for (size_t c = chunks * q / n; c < chunks * (q + 1) / n; ++c)
+                {
+                    size_t b = begin + c * chunk;
+                    queues_[q].tasks.push_back(Task{&job, b, std::min(end, b + chunk)});
+                }
+            }
+            {
+                std::lock_guard<std::mutex> lock(sleep_mutex_);
+                pending_ += chunks;
+            }
+            wake_.notify_all();
+
+            if (current_pool() == this)
+            {
+                // Nested call from a worker: help until our chunks are done
+                while (job.remaining.load(std::memory_order_acquire) != 0)
+                {
+                    if (!run_one(current_slot()))
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+                std::lock_guard<std::mutex> lock(job.mutex); // Wait for the last finisher to let go of job
+            }
+            else
+            {
+                std::unique_lock<std::mutex> lock(job.mutex);
+                job.done.wait(lock, [&job]()
+                              { return job.remaining.load(std::memory_order_acquire) == 0; });
+            }
+            if (job.error)
+            {
+                std::rethrow_exception(job.error);
+            }
+        }
+
+        // Process-wide pool with num_threads threads, created on first use and
+        // shared by every caller asking for the same size.
+        static std::shared_ptr<ThreadPool> shared(size_t num_threads)
+        {
+            static std::mutex mutex;
+            static std::map<size_t, std::shared_ptr<ThreadPool>> pools;
+            num_threads = std::max<size_t>(1, num_threads);
+            std::lock_guard<std::mutex> lock(mutex);
+            auto &pool = pools[num_threads];
+            if (!pool)
+            {
+                pool = std::make_shared<ThreadPool>(num_threads);
+            }
+            return pool;
+        }
+
+    private:
+        struct Job
+        {
+            void *fn = nullptr;
+            void (*call)(void *, size_t, size_t) = nullptr;
+            std::atomic<size_t> remaining{0};
+            std::mutex mutex;
+            std::condition_variable done;
+            std::exception_ptr error;
+        };
+
+        struct Task
+        {
+            Job *job;
+            size_t begin;
+            size_t end;
+        };
+
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        static const ThreadPool *&current_pool()
+        {
+            thread_local const ThreadPool *pool = nullptr;
+            return pool;
+        }
+
+        static size_t &current_slot()
+        {
+            thread_local size_t slot = 0;
+            return slot;
+        }
+
+        // Takes a task (own deque first, then steals) and runs it.
+        bool run_one(size_t slot)
+        {
+            Task task{nullptr, 0, 0};
+            const size_t n = queues_.size();
+            for (size_t i = 0; i < n && !task.job; ++i)
+            {
+                Queue &queue = queues_[(slot + i) % n];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                if (queue.tasks.empty())
+                {
+                    continue;
+                }
+                if (i == 0)
+                {
+                    task = queue.tasks.back();
+                    queue.tasks.pop_back();
+                }
+                else
+                {
+                    task = queue.tasks.front();
+                    queue.tasks.pop_front();
+                }
+            }
+            if (!task.job)
+            {
+                return false;
+            }
+            pending_.fetch_sub(1, std::memory_order_relaxed);
+
+            Job &job = *task.job;
+            try
+            {
+                job.call(job.fn, task.begin, task.end);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(job.mutex);
+                if (!job.error)
+                {
+                    job.error = std::current_exception();
+                }
+            }
+            // The job may be destroyed as soon as remaining reaches zero
+            std::lock_guard<std::mutex> lock(job.mutex);
+            if (job.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                job.done.notify_all();
+            }
+            return true;
+        }
+
+        void run(size_t slot)
+        {
+            current_pool() = this;
+            current_slot() = slot;
+            trace::set_thread_name("pool worker");
+            worker_ids_[slot].store(perf::thread_id(), std::memory_order_release);
+            while (true)
+            {
+                if (run_one(slot))
+                {
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(sleep_mutex_);
+                wake_.wait(lock, [this]()
+                           { return stop_ || pending_.load(std::memory_order_relaxed) > 0; });
+                if (stop_ && pending_.load(std::memory_order_relaxed) == 0)
+                {
+                    return;
+                }
+            }
+        }
+
+        std::vector<Queue> queues_;
+        std::vector<std::thread> workers_;
+        std::vector<std::atomic<long>> worker_ids_; // Thread ids for hardware counters
+        std::mutex counters_mutex_;
+        std::vector<std::unique_ptr<perf::CounterGroup>> worker_counters_;
+        std::mutex sleep_mutex_;
+        std::condition_variable wake_;
+        std::atomic<size_t> pending_{0};
+        bool stop_ = false;
+    };
+
+    // Pool for a run: the injected config.thread_pool, or the process-wide pool
+    // sized from config.num_threads.
+    inline ThreadPool &pool_for(const RegridConfig &config)
+    {
+        if (config.thread_pool)
+        {
+            return *config.thread_pool;
+        }
+        return *ThreadPool::shared(utils::resolve_num_threads(config.num_threads)); // Lives until exit
+    }
+
+} // namespace fastregrid
+
+#endif // FASTREGRID_THREAD_POOL_H
@@ -0,0 +1,330 @@
+/*
+ * tiling.h
+ * Spatial tiles and on-disk row spools for tiled regridding of very large grids in FastRegrid.
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#ifndef FASTREGRID_TILING_H
+#define FASTREGRID_TILING_H
+
+#include "config.h"
+#include "types.h"
+#include "grid_store.h"
+#include "memory.h"
+#include "utils.h"
+#include <vector>
+#include <map>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+namespace fastregrid
+{
+
+    // Square tiles of tile_size degrees over lon [-360, 360] x lat [-90, 90].
+    // Tile ids run latitude-fastest. Each tile row (latitude band) has a search
+    // halo wide enough that every source within config.radius of a target in
+    // the band lies inside the tile extended by the halo.
+    class TileLayout
+    {
+    public:
+        TileLayout(double tile_size, const RegridConfig &config)
+            : size_(tile_size), metric_(config.distance_metric)
+        {
+            if (!(tile_size > 0.0))
+            {
+                throw std::invalid_argument("Tile size must be positive");
+            }
+            columns_ = static_cast<size_t>(std::ceil(720.0 / size_));
+            rows_ = static_cast<size_t>(std::ceil(180.0 / size_));
+            halo_lon_.resize(rows_);
+            halo_lat_.resize(rows_);
+            for (size_t row = 0; row < rows_; ++row)
+            {
+                const double lat_lo = -90.0 + row * size_;
+                const double lat_hi = std::min(90.0, lat_lo + size_);
+                const double max_abs_lat = std::min(90.0, std::max(std::abs(lat_lo), std::abs(lat_hi)));
+                if (metric_ == HAVERSINE)
+                {
+                    // Spherical cap of angular radius d around a target at latitude phi spans
+                    // d in latitude and asin(sin d / cos phi) in longitude.
+                    constexpr double EARTH_RADIUS_KM = 6371.0;
+                    const double d = std::min(M_PI, config.radius / EARTH_RADIUS_KM);
+                    const double cos_phi = std::cos(utils::to_radians(max_abs_lat));
+                    halo_lat_[row] = d * 180.0 / M_PI;
+                    halo_lon_[row] = std::sin(d) < cos_phi ? std::asin(std::sin(d) / cos_phi) * 180.0 / M_PI : 360.0;
+                }
+                else
+                {
+                    // Euclidean search radius in degrees grows with target latitude
+                    halo_lat_[row] = halo_lon_[row] = std::min(720.0, utils::km_to_degrees(config.radius, max_abs_lat));
+                }
+                halo_lat_[row] *= 1.0 + 1e-9;
+                halo_lon_[row] *= 1.0 + 1e-9;
+                max_halo_lat_ = std::max(max_halo_lat_, halo_lat_[row]);
+            }
+        }
+
+        double tile_size() const { return size_; }
+
+        size_t tile_of(double lon, double lat) const
+        {
+            return column(lon) * rows_ + row(lat);
+        }
+
+        // Calls fn(tile) once for every tile whose extent plus halo contains (lon, lat).
+        template <typename Fn>
+        void for_each_halo_tile(double lon, double lat, Fn &&fn)
+        {
+            tiles_.clear();
+            const size_t row_begin = row(lat - max_halo_lat_);
+            const size_t row_end = row(lat + max_halo_lat_);
+            for (size_t r = row_begin; r <= row_end; ++r)
+            {
+                const double lat_lo = -90.0 + r * size_;
+                const double lat_hi = lat_lo + size_;
+                if (lat < lat_lo - halo_lat_[r] || lat > lat_hi + halo_lat_[r])
+                {
+                    continue;
+                }
+                if (halo_lon_[r] >= 180.0)
+                {
+                    for (size_t c = 0; c < columns_; ++c)
+                    {
+                        tiles_.push_back(c * rows_ + r);
+                    }
+                    continue;
+                }
+                // Haversine distances wrap around the antimeridian; Euclidean ones do not
+                for (double shift : {-360.0, 0.0, 360.0})
+                {
+                    if (shift != 0.0 && metric_ != HAVERSINE)
+                    {
+                        continue;
+                    }
+                    const double lo = lon + shift - halo_lon_[r];
+                    const double hi = lon + shift + halo_lon_[r];
+                    if (hi < -360.0 || lo > 360.0)
+                    {
+                        continue;
+                    }
+                    for (size_t c = column(lo); c <= column(hi); ++c)
+                    {
+                        tiles_.push_back(c * rows_ + r);
+                    }
+                }
+            }
+            std::sort(tiles_.begin(), tiles_.end());
+            tiles_.erase(std::unique(tiles_.begin(), tiles_.end()), tiles_.end());
+            for (size_t tile : tiles_)
+            {
+                fn(tile);
+            }
+        }
+
+    private:
+        size_t column(double lon) const
+        {
+            double c = std::floor((lon + 360.0) / size_);
+            return static_cast<size_t>(std::min<double>(columns_ - 1, std::max(0.0, c)));
+        }
+
+        size_t row(double lat) const
+        {
+            double r = std::floor((lat + 90.0) / size_);
+            return static_cast<size_t>(std::min<double>(rows_ - 1, std::max(0.0, r)));
+        }
+
+        double size_;
+        DistanceMetric metric_;
+        size_t columns_ = 0;
+        size_t rows_ = 0;
+        std::vector<double> halo_lon_; // Per tile row, degrees
+        std::vector<double> halo_lat_; // Per tile row, degrees
+        double max_halo_lat_ = 0.0;
+        std::vector<size_t> tiles_; // Scratch for for_each_halo_tile
+    };
+
+    // Uniquely named scratch directory; files created through file() are
+    // removed, with the directory, on destruction.
+    class ScratchDirectory
+    {
+    public:
+        explicit ScratchDirectory(std::string parent)
+        {
+#ifdef _WIN32
+            (void)parent;
+            throw std::runtime_error("Tiled regridding requires a POSIX system");
+#else
+            if (parent.empty())
+            {
+                const char *tmpdir = std::getenv("TMPDIR");
+                parent = tmpdir && *tmpdir ? tmpdir : "/tmp";
+            }
+            if (parent.back() != '/')
+            {
+                parent += '/';
+            }
+            std::string path = parent + "fastregrid_tiles_XXXXXX";
+            if (!mkdtemp(&path[0]))
+            {
+                throw std::runtime_error("Cannot create scratch directory in: " + parent);
+            }
+            path_ = path + '/';
+#endif
+        }
+
+        ScratchDirectory(const ScratchDirectory &) = delete;
+        ScratchDirectory &operator=(const ScratchDirectory &) = delete;
+
+        ~ScratchDirectory()
+        {
+            for (const auto &file : files_)
+            {
+                std::remove(file.c_str());
+            }
+#ifndef _WIN32
+            rmdir(path_.c_str());
+#endif
+        }
+
+        // Path of a scratch file named name (registered for removal).
+        std::string file(const std::string &name)
+        {
+            files_.push_back(path_ + name);
+            return files_.back();
+        }
+
+    private:
+        std::string path_;
+        std::vector<std::string> files_;
+    };
+
+    // Appends rows (lon, lat, time_step, values) to one binary file per tile,
+    // buffering at most buffer_bytes in memory across all tiles.
+    class TileSpool
+    {
+    public:
+        TileSpool(ScratchDirectory &scratch, const std::string &name, size_t stride,
+                  size_t buffer_bytes = size_t(64) << 20)
+            : scratch_(scratch), name_(name), stride_(stride), buffer_bytes_(buffer_bytes)
+        {
+        }
+
+        size_t stride() const { return stride_; }
+        bool contains(size_t tile) const { return files_.count(tile) != 0; }
+
+        // Tiles with at least one row, in ascending order.
+        std::vector<size_t> tiles() const
+        {
+            std::vector<size_t> tiles;
+            tiles.reserve(files_.size());
+            for (const auto &entry : files_)
+            {
+                tiles.push_back(entry.first);
+            }
+            return tiles;
+        }
+
+        void append(size_t tile, double lon, double lat, int time_step, const ValueType *values)
+        {
+            auto it = files_.find(tile);
+            if (it == files_.end())
+            {
+                it = files_.emplace(tile, scratch_.file(name_ + "_" + std::to_string(tile) + ".bin")).first;
+            }
+            std::vector<char> &buffer = buffers_[tile];
+            const size_t offset = buffer.size();
+            buffer.resize(offset + record_bytes());
+            char *record = buffer.data() + offset;
+            std::memcpy(record, &lon, sizeof(double));
+            std::memcpy(record + sizeof(double), &lat, sizeof(double));
+            std::memcpy(record + 2 * sizeof(double), &time_step, sizeof(int));
+            if (stride_ > 0)
+            {
+                std::memcpy(record + 2 * sizeof(double) + sizeof(int), values, stride_ * sizeof(ValueType));
+            }
+            buffered_ += record_bytes();
+            if (buffered_ >= buffer_bytes_)
+            {
+                flush();
+            }
+        }
+
+        // Writes all buffered rows to their tile files.
+        void flush()
+        {
+            for (auto &[tile, buffer] : buffers_)
+            {
+                std::ofstream file(files_.at(tile), std::ios::binary | std::ios::app);
+                if (!file.write(buffer.data(), static_cast<std::streamsize>(buffer.size())))
+                {
+                    throw std::runtime_error("Cannot write tile spool file: " + files_.at(tile));
+                }
+            }
+            buffers_.clear();
+            buffered_ = 0;
+        }
+
+        // Reads the rows of a tile (after flush()); empty if the tile has none.
+        GridStore read(size_t tile, const LargeBufferPolicy &policy = LargeBufferPolicy()) const
+        {
+            GridStore rows(stride_, policy);
+            auto it = files_.find(tile);
+            if (it == files_.end())
+            {
+                return rows;
+            }
+            std::ifstream file(it->second, std::ios::binary);
+            if (!file.is_open())
+            {
+                throw std::runtime_error("Cannot open tile spool file: " + it->second);
+            }
+            std::vector<char> record(record_bytes());
+            std::vector<ValueType> values(stride_);
+            while (file.read(record.data(), static_cast<std::streamsize>(record.size())))
+            {
+                double lon, lat;
+                int time_step;
+                std::memcpy(&lon, record.data(), sizeof(double));
+                std::memcpy(&lat, record.data() + sizeof(double), sizeof(double));
+                std::memcpy(&time_step, record.data() + 2 * sizeof(double), sizeof(int));
+                if (stride_ > 0)
+                {
+                    std::memcpy(values.data(), record.data() + 2 * sizeof(double) + sizeof(int), stride_ * sizeof(ValueType));
+                }
+                rows.push_back(lon, lat, time_step, values.data());
+            }
+            return rows;
+        }
+
+    private:
+        size_t record_bytes() const { return 2 * sizeof(double) + sizeof(int) + stride_ * sizeof(ValueType); }
+
+        ScratchDirectory &scratch_;
+        std::string name_;
+        size_t stride_;
+        size_t buffer_bytes_;
+        size_t buffered_ = 0;
+        std::map<size_t, std::string> files_;
+        std::map<size_t, std::vector<char>> buffers_;
+    };
+
+} // namespace fastregrid
+
+#endif // FASTREGRID_TILING_H
@@ -0,0 +1,274 @@
+/*
+ * trace.h
+ * Per-thread stage timelines of FastRegrid runs, written as Chrome trace-event JSON.
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#ifndef FASTREGRID_TRACE_H
+#define FASTREGRID_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fastregrid
+{
+    namespace trace
+    {
+
+        // One timed span on one thread.
+        struct Event
+        {
+            const char *name;     // Static string
+            const char *arg_name; // Static string, or null for no argument
+            uint64_t arg;
+            int64_t begin; // Nanoseconds since the recording started
+            int64_t end;
+        };
+
+        // Events of one thread. Only the owning thread appends; events are read
+        // once the recording has stopped.
+        struct ThreadBuffer
+        {
+            uint32_t id = 0;
+            const char *name = nullptr;
+            std::vector<Event> events;
+            std::atomic<bool> retired{false}; // Owning thread has exited
+        };
+
+        // Name of the calling thread in traces (a static string). Cheap: does not
+        // allocate a buffer unless the thread records events.
+        inline const char *&thread_name()
+        {
+            thread_local const char *name = nullptr;
+            return name;
+        }
+
+        inline void set_thread_name(const char *name) { thread_name() = name; }
+
+        // Process-wide recorder. While no recording is active, instrumented code
+        // pays one relaxed atomic load per span. One recording at a time.
+        class Tracer
+        {
+        public:
+            static Tracer &instance()
+            {
+                static Tracer tracer;
+                return tracer;
+            }
+
+            static bool active() { return active_.load(std::memory_order_relaxed); }
+
+            // Nanoseconds since the recording started.
+            int64_t now() const
+            {
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch_).count();
+            }
+
+            // Drops previous events and starts recording.
+            void start()
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                std::vector<std::shared_ptr<ThreadBuffer>> live;
+                for (auto &buffer : buffers_)
+                {
+                    if (!buffer->retired.load(std::memory_order_acquire))
+                    {
+                        buffer->events.clear();
+                        live.push_back(buffer);
+                    }
+                }
+                buffers_ = std::move(live);
+                epoch_ = Clock::now();
+                active_.store(true, std::memory_order_release);
+            }
+
+            void stop() { active_.store(false, std::memory_order_release); }
+
+            void record(const char *name, int64_t begin, int64_t end, const char *arg_name, uint64_t arg)
+            {
+                local().events.push_back(Event{name, arg_name, arg, begin, end});
+            }
+
+            // Writes the recorded events as a Chrome trace-event JSON file (loads in
+            // Perfetto and chrome://tracing). Call after stop(), once the threads
+            // that recorded have finished their work.
+            void write_json(const std::string &filename) const
+            {
+                std::ofstream file(filename);
+                if (!file.is_open())
+                {
+                    throw std::runtime_error("Cannot open trace file: " + filename);
+                }
+                std::lock_guard<std::mutex> lock(mutex_);
+                file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+                bool first = true;
+                char line[512];
+                for (const auto &buffer : buffers_)
+                {
+                    if (buffer->events.empty())
+                    {
+                        continue;
+                    }
+                    std::snprintf(line, sizeof(line),
+                                  "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"%s %u\"}}",
+                                  first ? "" : ",\n", buffer->id, buffer->name ? buffer->name : "thread", buffer->id);
+                    file << line;
+                    first = false;
+                    for (const auto &event : buffer->events)
+                    {
+                        int used = std::snprintf(line, sizeof(line),
+                                                 ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f",
+                                                 event.name, buffer->id, event.begin * 1e-3, (event.end - event.begin) * 1e-3);
+                        if (event.arg_name && used > 0 && static_cast<size_t>(used) < sizeof(line))
+                        {
+                            std::snprintf(line + used, sizeof(line) - used, ", \"args\": {\"%s\": %llu}", event.arg_name,
+                                          static_cast<unsigned long long>(event.arg));
+                        }
+                        file << line << '}';
+                    }
+                }
+                file << "\n]}\n";
+                if (!file)
+                {
+                    throw std::runtime_error("Cannot write trace file: " + filename);
+                }
+            }
+
+        private:
+            using Clock = std::chrono::steady_clock;
+
+            // Marks the buffer retired when its thread exits.
+            struct Owner
+            {
+                std::shared_ptr<ThreadBuffer> buffer;
+                ~Owner()
+                {
+                    if (buffer)
+                    {
+                        buffer->retired.store(true, std::memory_order_release);
+                    }
+                }
+            };
+
+            Tracer() = default;
+
+            ThreadBuffer &local()
+            {
+                thread_local Owner owner;
+                if (!owner.buffer)
+                {
+                    owner.buffer = std::make_shared<ThreadBuffer>();
+                    owner.buffer->events.reserve(1024);
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    owner.buffer->id = next_id_++;
+                    buffers_.push_back(owner.buffer);
+                }
+                owner.buffer->name = thread_name();
+                return *owner.buffer;
+            }
+
+            inline static std::atomic<bool> active_{false};
+            Clock::time_point epoch_ = Clock::now();
+            mutable std::mutex mutex_;
+            std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+            uint32_t next_id_ = 1;
+        };
+
+        // Records the span from construction to destruction on the calling
+        // thread, with an optional numeric argument (e.g. a chunk's first row).
+        class Scope
+        {
+        public:
+            explicit Scope(const char *name, const char *arg_name = nullptr, uint64_t arg = 0)
+                : name_(Tracer::active() ? name : nullptr), arg_name_(arg_name), arg_(arg),
+                  begin_(name_ ? Tracer::instance().now() : 0)
+            {
+            }
+
+            Scope(const Scope &) = delete;
+            Scope &operator=(const Scope &) = delete;
+
+            // Ends the current span and starts the next one, with argument arg.
+            void next(uint64_t arg)
+            {
+                if (name_ && Tracer::active())
+                {
+                    Tracer &tracer = Tracer::instance();
+                    const int64_t now = tracer.now();
+                    tracer.record(name_, begin_, now, arg_name_, arg_);
+                    begin_ = now;
+                }
+                arg_ = arg;
+            }
+
+            ~Scope()
+            {
+                if (name_ && Tracer::active())
+                {
+                    Tracer &tracer = Tracer::instance();
+                    tracer.record(name_, begin_, tracer.now(), arg_name_, arg_);
+                }
+            }
+
+        private:
+            const char *name_;
+            const char *arg_name_;
+            uint64_t arg_;
+            int64_t begin_;
+        };
+
+        // Records events from construction until destruction if enabled, e.g. for
+        // one run with config.write_trace.
+        class Recording
+        {
+        public:
+            explicit Recording(bool enabled) : enabled_(enabled)
+            {
+                if (enabled_)
+                {
+                    Tracer::instance().start();
+                }
+            }
+
+            Recording(const Recording &) = delete;
+            Recording &operator=(const Recording &) = delete;
+
+            ~Recording()
+            {
+                if (enabled_)
+                {
+                    Tracer::instance().stop();
+                }
+            }
+
+            // Stops recording and writes the events to filename.
+            void write(const std::string &filename) const
+            {
+                if (enabled_)
+                {
+                    Tracer::instance().stop();
+                    Tracer::instance().write_json(filename);
+                }
+            }
+
+        private:
+            bool enabled_;
+        };
+
+    } // namespace trace
+} // namespace fastregrid
+
+#endif // FASTREGRID_TRACE_H
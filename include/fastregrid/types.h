@@ -14,10 +14,23 @@
 
 #include <vector>
 #include <string>
+#include <tuple>
+#include <cstddef>
+#include <memory_resource>
 
 namespace fastregrid
 {
 
+    // Scalar type for stored data values and interpolation arithmetic.
+    // Coordinates and distances always stay in double. Define
+    // FASTREGRID_SINGLE_PRECISION (CMake option of the same name) to halve
+    // value memory and double the SIMD width of the apply kernels.
+#ifdef FASTREGRID_SINGLE_PRECISION
+    using ValueType = float;
+#else
+    using ValueType = double;
+#endif
+
     // Represents a geospatial point with longitude and latitude.
     struct GridPoint
     {
@@ -26,6 +39,7 @@ namespace fastregrid
     };
 
     // Represents data for a grid point at a specific time step.
+    // Bulk data is held in GridStore (grid_store.h); this is its per-row compatibility view.
     struct SpatialData
     {
         GridPoint gridPoint;        // Geospatial coordinates
@@ -33,6 +47,41 @@ namespace fastregrid
         std::vector<double> values; // Data values (e.g., 12 monthly values)
     };
 
+    // Non-owning view of contiguous elements (stand-in for C++20 std::span).
+    template <typename T>
+    class Span
+    {
+    public:
+        Span() = default;
+        Span(T *data, size_t size) : data_(data), size_(size) {}
+        template <typename Container>
+        Span(Container &container) : data_(container.data()), size_(container.size()) {}
+
+        T *data() const { return data_; }
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+        T &operator[](size_t i) const { return data_[i]; }
+        T *begin() const { return data_; }
+        T *end() const { return data_ + size_; }
+
+    private:
+        T *data_ = nullptr;
+        size_t size_ = 0;
+    };
+
+    // Nearest Neighbor mapping:
+    // (target_lon, target_lat, source_lon, source_lat, distance_km, target_index, source_index).
+    using NNMapping = std::tuple<double, double, double, double, double, size_t, size_t>;
+
+    // IDW neighbour: (source_lon, source_lat, distance_km, source_index).
+    using IDWNeighbor = std::tuple<double, double, double, size_t>;
+
+    // IDW neighbour list, allocated from the per-run arena.
+    using IDWNeighbors = std::pmr::vector<IDWNeighbor>;
+
+    // IDW mapping: (target_lon, target_lat, neighbours, target_index, is_fallback).
+    using IDWMapping = std::tuple<double, double, IDWNeighbors, size_t, bool>;
+
     // Interpolation method options.
     enum InterpolationMethod
     {
@@ -54,6 +103,13 @@ namespace fastregrid
         GRID_BY_TIME  // If file contains data for one grid cell, all years //Can contain all gridcells in one file
     };
 
+    // NUMA placement for large buffers.
+    enum NumaPlacement
+    {
+        NUMA_LOCAL,      // Pages land on the node of the thread that first touches them
+        NUMA_INTERLEAVED // Pages are spread round-robin over all allowed nodes
+    };
+
 } // namespace fastregrid
 
 #endif // FASTREGRID_TYPES_H
\ No newline at end of file
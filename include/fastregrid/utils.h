@@ -17,6 +17,10 @@
 #include <cmath>
 #include <math.h>
 #include <stdexcept>
+#include <thread>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
 
 namespace fastregrid
 {
@@ -24,6 +28,38 @@ namespace fastregrid
     namespace utils
     {
 
+        // Resolves a configured thread count; 0 means all hardware threads.
+        inline size_t resolve_num_threads(size_t requested)
+        {
+            if (requested != 0)
+            {
+                return requested;
+            }
+            size_t hardware = std::thread::hardware_concurrency();
+            return hardware == 0 ? 1 : hardware;
+        }
+
+        // Z-order (Morton) key of a location: interleaves 32-bit quantized
+        // longitude and latitude, so sorting by key keeps nearby locations close.
+        inline uint64_t morton_key(double lon, double lat)
+        {
+            auto quantize = [](double value, double lo, double hi) -> uint64_t
+            {
+                double t = std::min(1.0, std::max(0.0, (value - lo) / (hi - lo)));
+                return static_cast<uint64_t>(t * 4294967295.0);
+            };
+            auto spread = [](uint64_t v) -> uint64_t
+            {
+                v = (v | (v << 16)) & 0x0000FFFF0000FFFFULL;
+                v = (v | (v << 8)) & 0x00FF00FF00FF00FFULL;
+                v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+                v = (v | (v << 2)) & 0x3333333333333333ULL;
+                v = (v | (v << 1)) & 0x5555555555555555ULL;
+                return v;
+            };
+            return spread(quantize(lon, -360.0, 360.0)) | (spread(quantize(lat, -90.0, 90.0)) << 1);
+        }
+
         // Converts degrees to radians.
         inline double to_radians(double degrees)
         {
@@ -67,7 +103,7 @@ namespace fastregrid
 
         // Computes distance between two points using Haversine or Euclidean metric.
         // Returns distance in km (Haversine) or degrees (Euclidean, convert to km for output).
-        double compute_distance(double lon1, double lat1, double lon2, double lat2,
+        inline double compute_distance(double lon1, double lat1, double lon2, double lat2,
                                 DistanceMetric metric)
         {
             // Validate inputs.
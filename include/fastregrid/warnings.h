@@ -0,0 +1,225 @@
+/*
+ * warnings.h
+ * Aggregated, rate-limited per-target warnings of the search and interpolation in FastRegrid.
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#ifndef FASTREGRID_WARNINGS_H
+#define FASTREGRID_WARNINGS_H
+
+#include "logger.h"
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <string>
+
+namespace fastregrid
+{
+
+    // Kinds of warning raised once per target (or target row).
+    enum WarningKind
+    {
+        WARNING_IDW_FALLBACK,          // Fewer than min_points sources within radius
+        WARNING_NEAREST_BEYOND_RADIUS, // Nearest source farther than radius
+        WARNING_MISSING_SOURCE_VALUE,  // Source location has no value at the row's time step
+        WARNING_KINDS
+    };
+
+    // Occurrences of one kind: count, distances to the nearest source in
+    // multiples of the radius R (<R, R-2R, 2R-4R, 4R-8R, >=8R) and the bounding
+    // box of the targets concerned.
+    struct WarningTally
+    {
+        static constexpr size_t BINS = 5;
+
+        uint64_t count = 0;
+        uint64_t histogram[BINS] = {};
+        double min_lon = std::numeric_limits<double>::infinity();
+        double max_lon = -std::numeric_limits<double>::infinity();
+        double min_lat = std::numeric_limits<double>::infinity();
+        double max_lat = -std::numeric_limits<double>::infinity();
+
+        // distance_km is NaN for kinds without a distance.
+        void add(double lon, double lat, double distance_km, double radius_km)
+        {
+            ++count;
+            min_lon = std::min(min_lon, lon);
+            max_lon = std::max(max_lon, lon);
+            min_lat = std::min(min_lat, lat);
+            max_lat = std::max(max_lat, lat);
+            if (!std::isnan(distance_km))
+            {
+                size_t bin = 0;
+                for (double limit = radius_km; bin + 1 < BINS && distance_km >= limit; limit *= 2)
+                {
+                    ++bin;
+                }
+                ++histogram[bin];
+            }
+        }
+
+        void merge(const WarningTally &other)
+        {
+            count += other.count;
+            for (size_t bin = 0; bin < BINS; ++bin)
+            {
+                histogram[bin] += other.histogram[bin];
+            }
+            min_lon = std::min(min_lon, other.min_lon);
+            max_lon = std::max(max_lon, other.max_lon);
+            min_lat = std::min(min_lat, other.min_lat);
+            max_lat = std::max(max_lat, other.max_lat);
+        }
+    };
+
+    using WarningTallies = std::array<WarningTally, WARNING_KINDS>;
+
+    // Warnings of a search or interpolation, aggregated by kind instead of one
+    // log line each. Callers tally occurrences locally (per task) and merge()
+    // them once; only the first `examples` occurrences of each kind are logged
+    // in full, as they happen. report() logs a summary table and clears the
+    // counts; it runs on destruction if anything is left to report.
+    class WarningSummary
+    {
+    public:
+        WarningSummary(double radius_km, size_t examples) : radius_km_(radius_km), examples_(examples) {}
+
+        WarningSummary(const WarningSummary &) = delete;
+        WarningSummary &operator=(const WarningSummary &) = delete;
+
+        ~WarningSummary()
+        {
+            try
+            {
+                report();
+            }
+            catch (...)
+            {
+            }
+        }
+
+        double radius_km() const { return radius_km_; }
+
+        // True if this occurrence of kind should be logged in full. Once the
+        // examples are used up, notes once that the rest are only counted.
+        bool example(WarningKind kind)
+        {
+            if (logged_[kind].load(std::memory_order_relaxed) > examples_)
+            {
+                return false;
+            }
+            const size_t index = logged_[kind].fetch_add(1, std::memory_order_relaxed);
+            if (index == examples_)
+            {
+                log_warning("Further \"{}\" warnings are counted, not logged; see the warning summary", label(kind));
+            }
+            return index < examples_;
+        }
+
+        void merge(const WarningTallies &tallies)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t kind = 0; kind < WARNING_KINDS; ++kind)
+            {
+                totals_[kind].merge(tallies[kind]);
+            }
+        }
+
+        WarningTallies totals() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return totals_;
+        }
+
+        // Logs one line per kind that occurred, then starts over.
+        void report()
+        {
+            WarningTallies totals;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                totals = totals_;
+                totals_ = WarningTallies();
+                for (auto &logged : logged_)
+                {
+                    logged.store(0, std::memory_order_relaxed);
+                }
+            }
+            bool any = false;
+            for (const auto &tally : totals)
+            {
+                any = any || tally.count != 0;
+            }
+            if (!any)
+            {
+                return;
+            }
+
+            char line[256];
+            log_warning("Warning summary (distance to nearest source in multiples of the radius R = {} km):", radius_km_);
+            std::snprintf(line, sizeof(line), "%-30s %10s  %-20s  %-20s %8s %8s %8s %8s %8s", "Kind", "Count",
+                          "Longitudes", "Latitudes", "<R", "R-2R", "2R-4R", "4R-8R", ">=8R");
+            log_warning("{}", line);
+            for (size_t kind = 0; kind < WARNING_KINDS; ++kind)
+            {
+                const WarningTally &tally = totals[kind];
+                if (tally.count == 0)
+                {
+                    continue;
+                }
+                char lons[32], lats[32];
+                std::snprintf(lons, sizeof(lons), "[%.2f, %.2f]", tally.min_lon, tally.max_lon);
+                std::snprintf(lats, sizeof(lats), "[%.2f, %.2f]", tally.min_lat, tally.max_lat);
+                int used = std::snprintf(line, sizeof(line), "%-30s %10llu  %-20s  %-20s", label(static_cast<WarningKind>(kind)),
+                                         static_cast<unsigned long long>(tally.count), lons, lats);
+                for (size_t bin = 0; bin < WarningTally::BINS && used > 0 && static_cast<size_t>(used) < sizeof(line); ++bin)
+                {
+                    if (kind == WARNING_MISSING_SOURCE_VALUE)
+                    {
+                        used += std::snprintf(line + used, sizeof(line) - used, " %8s", "-");
+                    }
+                    else
+                    {
+                        used += std::snprintf(line + used, sizeof(line) - used, " %8llu",
+                                              static_cast<unsigned long long>(tally.histogram[bin]));
+                    }
+                }
+                log_warning("{}", line);
+            }
+        }
+
+        static const char *label(WarningKind kind)
+        {
+            switch (kind)
+            {
+            case WARNING_IDW_FALLBACK:
+                return "IDW fallback to nearest";
+            case WARNING_NEAREST_BEYOND_RADIUS:
+                return "Nearest source beyond radius";
+            case WARNING_MISSING_SOURCE_VALUE:
+                return "Missing source value";
+            default:
+                return "Unknown";
+            }
+        }
+
+    private:
+        double radius_km_;
+        size_t examples_;
+        std::atomic<size_t> logged_[WARNING_KINDS] = {};
+        mutable std::mutex mutex_;
+        WarningTallies totals_;
+    };
+
+} // namespace fastregrid
+
+#endif // FASTREGRID_WARNINGS_H
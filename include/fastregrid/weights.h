@@ -0,0 +1,413 @@
+/*
+ * weights.h
+ * Precomputed source -> target interpolation weights for FastRegrid.
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#ifndef FASTREGRID_WEIGHTS_H
+#define FASTREGRID_WEIGHTS_H
+
+#include "config.h"
+#include "types.h"
+#include "memory.h"
+#include "arena.h"
+#include "spatial_index.h"
+#include <vector>
+#include <string>
+#include <fstream>
+#include <optional>
+#include <memory>
+#include <stdexcept>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace fastregrid
+{
+
+    // Sparse weights from source locations to target locations, stored flat:
+    // target t uses entries [begin(t), end(t)), each a (source index, weight)
+    // pair. Weights are raw (1/d^power, or 1 for NN); apply() normalizes by
+    // their sum. Immutable after construction, so apply() may run concurrently.
+    class RegridWeights
+    {
+    public:
+        RegridWeights() = default;
+
+        // From Nearest Neighbor mappings indexed by target location.
+        RegridWeights(const std::vector<NNMapping> &mappings, size_t source_size,
+                      const LargeBufferPolicy &policy = LargeBufferPolicy())
+            : RegridWeights(policy)
+        {
+            source_size_ = source_size;
+            offsets_.assign(mappings.size() + 1, 0);
+            sources_.resize(mappings.size());
+            weights_.assign(mappings.size(), ValueType(1));
+            fallback_.assign(mappings.size(), 0);
+            for (const auto &[target_lon, target_lat, source_lon, source_lat, distance, target_idx, source_idx] : mappings)
+            {
+                check_indices(target_idx, mappings.size(), source_idx);
+                sources_[target_idx] = source_idx;
+            }
+            for (size_t t = 0; t < mappings.size(); ++t)
+            {
+                offsets_[t + 1] = t + 1;
+            }
+        }
+
+        // From IDW mappings indexed by target location.
+        RegridWeights(const std::vector<IDWMapping> &mappings, double power, size_t source_size,
+                      const LargeBufferPolicy &policy = LargeBufferPolicy())
+            : RegridWeights(policy)
+        {
+            source_size_ = source_size;
+            offsets_.assign(mappings.size() + 1, 0);
+            fallback_.assign(mappings.size(), 0);
+            for (const auto &[target_lon, target_lat, neighbors, target_idx, is_fallback] : mappings)
+            {
+                check_indices(target_idx, mappings.size(), 0);
+                if (is_fallback && neighbors.size() != 1)
+                {
+                    throw std::runtime_error("Invalid fallback mapping: expected one source point");
+                }
+                offsets_[target_idx + 1] = neighbors.size();
+                fallback_[target_idx] = is_fallback;
+            }
+            for (size_t t = 0; t < mappings.size(); ++t)
+            {
+                offsets_[t + 1] += offsets_[t];
+            }
+            sources_.resize(offsets_.back());
+            weights_.resize(offsets_.back());
+            for (const auto &[target_lon, target_lat, neighbors, target_idx, is_fallback] : mappings)
+            {
+                size_t k = offsets_[target_idx];
+                for (const auto &[source_lon, source_lat, distance, source_idx] : neighbors)
+                {
+                    check_indices(target_idx, mappings.size(), source_idx);
+                    sources_[k] = source_idx;
+                    weights_[k] = is_fallback ? ValueType(1) : static_cast<ValueType>(idw_weight(distance, power));
+                    ++k;
+                }
+            }
+        }
+
+        // Searches the sources around each target and builds weights for config.interp_method.
+        static RegridWeights build(const double *source_lons, const double *source_lats, size_t source_count,
+                                   const double *target_lons, const double *target_lats, size_t target_count,
+                                   const RegridConfig &config)
+        {
+            SpatialIndex index(source_lons, source_lats, source_count, config);
+            if (config.interp_method == NEAREST_NEIGHBOR)
+            {
+                return RegridWeights(index.find_nearest_neighbors(target_lons, target_lats, target_count),
+                                     source_count, buffer_policy(config));
+            }
+            if (config.interp_method == INVERSE_DISTANCE_WEIGHTED)
+            {
+                ArenaSet arenas(pool_for(config).size());
+                return RegridWeights(index.find_idw_neighbors(target_lons, target_lats, target_count, arenas),
+                                     config.power, source_count, buffer_policy(config));
+            }
+            throw std::runtime_error("Unknown interpolation method");
+        }
+
+        // IDW weight of a source at distance km.
+        static double idw_weight(double distance, double power)
+        {
+            return distance > 1e-6 ? 1.0 / std::pow(distance, power) : 1e6; // Avoid division by zero
+        }
+
+        // Writes the weights to a binary file, tagged with the fingerprints of the
+        // grids and the search parameters of config they were built for.
+        void save(const std::string &filename, uint64_t source_fingerprint, uint64_t target_fingerprint,
+                  const RegridConfig &config) const
+        {
+            std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+            {
+                throw std::runtime_error("Cannot open weights file: " + filename);
+            }
+            const FileHeader header = make_header(source_fingerprint, target_fingerprint, config, source_size_,
+                                                  target_size(), nonzeros());
+            const Arrays arrays = this->arrays();
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char *>(arrays.offsets), (arrays.targets + 1) * sizeof(size_t));
+            file.write(reinterpret_cast<const char *>(arrays.sources), arrays.nonzeros * sizeof(size_t));
+            file.write(reinterpret_cast<const char *>(arrays.weights), arrays.nonzeros * sizeof(ValueType));
+            file.write(reinterpret_cast<const char *>(arrays.fallback), arrays.targets);
+            if (!file)
+            {
+                throw std::runtime_error("Cannot write weights file: " + filename);
+            }
+        }
+
+        // Reads weights written by save(). Returns nothing if the file does not
+        // exist or was written for other grids, search parameters or builds.
+        static std::optional<RegridWeights> load(const std::string &filename, uint64_t source_fingerprint,
+                                                 uint64_t target_fingerprint, const RegridConfig &config)
+        {
+            std::ifstream file(filename, std::ios::binary);
+            if (!file.is_open())
+            {
+                return std::nullopt;
+            }
+            FileHeader header;
+            if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)))
+            {
+                throw std::runtime_error("Truncated weights file: " + filename);
+            }
+            const FileHeader expected = make_header(source_fingerprint, target_fingerprint, config,
+                                                    header.source_size, header.target_size, header.nonzeros);
+            if (std::memcmp(&header, &expected, sizeof(header)) != 0)
+            {
+                return std::nullopt;
+            }
+            RegridWeights weights(buffer_policy(config));
+            weights.source_size_ = header.source_size;
+            weights.offsets_.resize(header.target_size + 1);
+            weights.sources_.resize(header.nonzeros);
+            weights.weights_.resize(header.nonzeros);
+            weights.fallback_.resize(header.target_size);
+            file.read(reinterpret_cast<char *>(weights.offsets_.data()), weights.offsets_.size() * sizeof(size_t));
+            file.read(reinterpret_cast<char *>(weights.sources_.data()), weights.sources_.size() * sizeof(size_t));
+            file.read(reinterpret_cast<char *>(weights.weights_.data()), weights.weights_.size() * sizeof(ValueType));
+            file.read(reinterpret_cast<char *>(weights.fallback_.data()), weights.fallback_.size());
+            if (!file || weights.offsets_.back() != header.nonzeros)
+            {
+                throw std::runtime_error("Truncated weights file: " + filename);
+            }
+            return weights;
+        }
+
+        // Maps weights written by save() read-only instead of reading them, so
+        // processes using the same file share one copy in the page cache.
+        // Returns nothing under the same conditions as load().
+        static std::optional<RegridWeights> map(const std::string &filename, uint64_t source_fingerprint,
+                                                uint64_t target_fingerprint, const RegridConfig &config)
+        {
+            std::ifstream probe(filename, std::ios::binary);
+            if (!probe.is_open())
+            {
+                return std::nullopt;
+            }
+            probe.close();
+            auto file = std::make_shared<const memory::MappedFile>(filename);
+            FileHeader header;
+            if (file->size() < sizeof(header))
+            {
+                throw std::runtime_error("Truncated weights file: " + filename);
+            }
+            std::memcpy(&header, file->data(), sizeof(header));
+            const FileHeader expected = make_header(source_fingerprint, target_fingerprint, config,
+                                                    header.source_size, header.target_size, header.nonzeros);
+            if (std::memcmp(&header, &expected, sizeof(header)) != 0)
+            {
+                return std::nullopt;
+            }
+            const size_t bytes = sizeof(header) + (header.target_size + 1 + header.nonzeros) * sizeof(size_t) +
+                                 header.nonzeros * sizeof(ValueType) + header.target_size;
+            if (file->size() < bytes)
+            {
+                throw std::runtime_error("Truncated weights file: " + filename);
+            }
+            RegridWeights weights(buffer_policy(config));
+            weights.source_size_ = header.source_size;
+            const char *data = static_cast<const char *>(file->data()) + sizeof(header);
+            Arrays &arrays = weights.mapped_arrays_;
+            arrays.offsets = reinterpret_cast<const size_t *>(data);
+            arrays.sources = arrays.offsets + header.target_size + 1;
+            arrays.weights = reinterpret_cast<const ValueType *>(arrays.sources + header.nonzeros);
+            arrays.fallback = reinterpret_cast<const uint8_t *>(arrays.weights + header.nonzeros);
+            arrays.targets = header.target_size;
+            arrays.nonzeros = header.nonzeros;
+            if (arrays.offsets[arrays.targets] != arrays.nonzeros)
+            {
+                throw std::runtime_error("Corrupt weights file: " + filename);
+            }
+            weights.mapped_ = std::move(file);
+            return weights;
+        }
+
+        // True if the weights live in a mapped file (see map()).
+        bool mapped() const { return mapped_ != nullptr; }
+
+        size_t source_size() const { return source_size_; }
+        size_t target_size() const { return arrays().targets; }
+        size_t nonzeros() const { return arrays().nonzeros; }
+        size_t begin(size_t target) const { return arrays().offsets[target]; }
+        size_t end(size_t target) const { return arrays().offsets[target + 1]; }
+        size_t source(size_t entry) const { return arrays().sources[entry]; }
+        ValueType weight(size_t entry) const { return arrays().weights[entry]; }
+        bool fallback(size_t target) const { return arrays().fallback[target] != 0; }
+
+        // For targets in [target_begin, target_end):
+        //   dst[t * dst_stride + j] = sum_k w_k * src[s_k * src_stride + j] / sum_k w_k,  j < count
+        void apply(const ValueType *src, size_t src_stride, ValueType *dst, size_t dst_stride, size_t count,
+                   size_t target_begin, size_t target_end) const
+        {
+            const Arrays arrays = this->arrays();
+            for (size_t t = target_begin; t < target_end; ++t)
+            {
+                ValueType *out = dst + t * dst_stride;
+                std::fill(out, out + count, ValueType(0));
+                ValueType weight_sum = 0;
+                for (size_t k = arrays.offsets[t]; k < arrays.offsets[t + 1]; ++k)
+                {
+                    const ValueType w = arrays.weights[k];
+                    const ValueType *in = src + arrays.sources[k] * src_stride;
+                    weight_sum += w;
+                    for (size_t j = 0; j < count; ++j)
+                    {
+                        out[j] += w * in[j];
+                    }
+                }
+                for (size_t j = 0; j < count; ++j)
+                {
+                    out[j] /= weight_sum;
+                }
+            }
+        }
+
+        void apply(const ValueType *src, size_t src_stride, ValueType *dst, size_t dst_stride, size_t count) const
+        {
+            apply(src, src_stride, dst, dst_stride, count, 0, target_size());
+        }
+
+        // General strided form: value j of location i is at src[i * src_location_stride + j * src_value_stride].
+        // Column-major (Fortran) arrays values(n_locations, count) use location stride 1 and
+        // value stride = leading dimension.
+        void apply(const ValueType *src, size_t src_location_stride, size_t src_value_stride,
+                   ValueType *dst, size_t dst_location_stride, size_t dst_value_stride,
+                   size_t count, size_t target_begin, size_t target_end) const
+        {
+            if (src_value_stride == 1 && dst_value_stride == 1)
+            {
+                apply(src, src_location_stride, dst, dst_location_stride, count, target_begin, target_end);
+                return;
+            }
+            const Arrays arrays = this->arrays();
+            // Walk one value column at a time so reads and writes stay sequential per column
+            for (size_t j = 0; j < count; ++j)
+            {
+                const ValueType *in = src + j * src_value_stride;
+                ValueType *out = dst + j * dst_value_stride;
+                for (size_t t = target_begin; t < target_end; ++t)
+                {
+                    ValueType value = 0;
+                    ValueType weight_sum = 0;
+                    for (size_t k = arrays.offsets[t]; k < arrays.offsets[t + 1]; ++k)
+                    {
+                        value += arrays.weights[k] * in[arrays.sources[k] * src_location_stride];
+                        weight_sum += arrays.weights[k];
+                    }
+                    out[t * dst_location_stride] = value / weight_sum;
+                }
+            }
+        }
+
+    private:
+        explicit RegridWeights(const LargeBufferPolicy &policy)
+            : offsets_(LargeBufferAllocator<size_t>(policy)),
+              sources_(LargeBufferAllocator<size_t>(policy)),
+              weights_(LargeBufferAllocator<ValueType>(policy))
+        {
+        }
+
+        // The flat arrays, wherever they live.
+        struct Arrays
+        {
+            const size_t *offsets = nullptr;
+            const size_t *sources = nullptr;
+            const ValueType *weights = nullptr;
+            const uint8_t *fallback = nullptr;
+            size_t targets = 0;
+            size_t nonzeros = 0;
+        };
+
+        Arrays arrays() const
+        {
+            if (mapped_)
+            {
+                return mapped_arrays_;
+            }
+            return Arrays{offsets_.data(), sources_.data(), weights_.data(), fallback_.data(), fallback_.size(),
+                          sources_.size()};
+        }
+
+        // Fixed-size header of a weights file. Fields are zero-initialized so
+        // padding compares equal.
+        struct FileHeader
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t value_bytes;
+            int32_t interp_method;
+            int32_t distance_metric;
+            double radius;
+            double power;
+            int32_t min_points;
+            int32_t max_points;
+            uint64_t source_fingerprint;
+            uint64_t target_fingerprint;
+            uint64_t source_size;
+            uint64_t target_size;
+            uint64_t nonzeros;
+        };
+
+        static FileHeader make_header(uint64_t source_fingerprint, uint64_t target_fingerprint,
+                                      const RegridConfig &config, uint64_t source_size, uint64_t target_size,
+                                      uint64_t nonzeros)
+        {
+            FileHeader header;
+            std::memset(&header, 0, sizeof(header));
+            std::memcpy(header.magic, "FRWGHTS", 8);
+            header.version = 1;
+            header.value_bytes = sizeof(ValueType);
+            header.interp_method = config.interp_method;
+            header.distance_metric = config.distance_metric;
+            // Only IDW weights depend on the search parameters
+            if (config.interp_method == INVERSE_DISTANCE_WEIGHTED)
+            {
+                header.radius = config.radius;
+                header.power = config.power;
+                header.min_points = config.min_points;
+                header.max_points = config.max_points;
+            }
+            header.source_fingerprint = source_fingerprint;
+            header.target_fingerprint = target_fingerprint;
+            header.source_size = source_size;
+            header.target_size = target_size;
+            header.nonzeros = nonzeros;
+            return header;
+        }
+
+        void check_indices(size_t target_idx, size_t target_count, size_t source_idx) const
+        {
+            if (target_idx >= target_count)
+            {
+                throw std::runtime_error("Invalid target index in mapping");
+            }
+            if (source_idx >= source_size_)
+            {
+                throw std::runtime_error("Invalid source index in mapping");
+            }
+        }
+
+        size_t source_size_ = 0;
+        LargeVector<size_t> offsets_;
+        LargeVector<size_t> sources_;
+        LargeVector<ValueType> weights_;
+        std::vector<uint8_t> fallback_;
+        std::shared_ptr<const memory::MappedFile> mapped_; // Set by map(); shared by copies
+        Arrays mapped_arrays_;
+    };
+
+} // namespace fastregrid
+
+#endif // FASTREGRID_WEIGHTS_H
@@ -0,0 +1,197 @@
+/*
+ * fastregrid_c.cpp
+ * Implements the C interface declared in fastregrid_c.h on top of RegridWeights.
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#include "fastregrid_c.h"
+#include "weights.h"
+#include <new>
+#include <string>
+#include <stdexcept>
+#include <type_traits>
+
+static_assert(std::is_same<fastregrid_value_t, fastregrid::ValueType>::value,
+              "fastregrid_value_t must match fastregrid::ValueType");
+static_assert(FASTREGRID_NEAREST_NEIGHBOR == fastregrid::NEAREST_NEIGHBOR &&
+                  FASTREGRID_INVERSE_DISTANCE_WEIGHTED == fastregrid::INVERSE_DISTANCE_WEIGHTED &&
+                  FASTREGRID_EUCLIDEAN == fastregrid::EUCLIDEAN &&
+                  FASTREGRID_HAVERSINE == fastregrid::HAVERSINE,
+              "C constants must match the C++ enums");
+
+struct fastregrid_weights
+{
+    fastregrid::RegridWeights weights;
+    bool built = false;
+};
+
+namespace
+{
+
+    thread_local std::string last_error;
+
+    int fail(int status, const char *message)
+    {
+        last_error = message;
+        return status;
+    }
+
+    // Runs fn, translating exceptions into status codes (none may cross the C boundary).
+    template <typename Fn>
+    int guarded(Fn &&fn)
+    {
+        try
+        {
+            last_error.clear();
+            fn();
+            return FASTREGRID_OK;
+        }
+        catch (const std::bad_alloc &)
+        {
+            return fail(FASTREGRID_ERROR_OUT_OF_MEMORY, "Out of memory");
+        }
+        catch (const std::invalid_argument &e)
+        {
+            return fail(FASTREGRID_ERROR_INVALID_ARGUMENT, e.what());
+        }
+        catch (const std::exception &e)
+        {
+            return fail(FASTREGRID_ERROR_RUNTIME, e.what());
+        }
+        catch (...)
+        {
+            return fail(FASTREGRID_ERROR_RUNTIME, "Unknown error");
+        }
+    }
+
+    fastregrid::RegridConfig to_config(const fastregrid_options &options)
+    {
+        if (options.interp_method != FASTREGRID_NEAREST_NEIGHBOR &&
+            options.interp_method != FASTREGRID_INVERSE_DISTANCE_WEIGHTED)
+        {
+            throw std::invalid_argument("Unknown interpolation method");
+        }
+        if (options.distance_metric != FASTREGRID_EUCLIDEAN && options.distance_metric != FASTREGRID_HAVERSINE)
+        {
+            throw std::invalid_argument("Unknown distance metric");
+        }
+        if (options.radius < 0.0 || options.max_points <= 0 || options.min_points <= 0 ||
+            options.min_points > options.max_points || options.num_threads < 0)
+        {
+            throw std::invalid_argument("Invalid search options");
+        }
+        if (!(options.power > 0.0)) // Also rejects NaN
+        {
+            throw std::invalid_argument("Power must be positive");
+        }
+        fastregrid::RegridConfig config;
+        config.interp_method = static_cast<fastregrid::InterpolationMethod>(options.interp_method);
+        config.distance_metric = static_cast<fastregrid::DistanceMetric>(options.distance_metric);
+        config.radius = options.radius;
+        config.power = options.power;
+        config.max_points = options.max_points;
+        config.min_points = options.min_points;
+        config.num_threads = static_cast<size_t>(options.num_threads);
+        config.verbose = options.verbose != 0;
+        return config;
+    }
+
+} // namespace
+
+extern "C"
+{
+
+    void fastregrid_default_options(fastregrid_options *options)
+    {
+        if (!options)
+        {
+            return;
+        }
+        const fastregrid::RegridConfig config;
+        options->interp_method = config.interp_method;
+        options->distance_metric = config.distance_metric;
+        options->radius = config.radius;
+        options->power = config.power;
+        options->max_points = config.max_points;
+        options->min_points = config.min_points;
+        options->num_threads = static_cast<int32_t>(config.num_threads);
+        options->verbose = config.verbose;
+    }
+
+    fastregrid_weights *fastregrid_weights_create(void)
+    {
+        return new (std::nothrow) fastregrid_weights();
+    }
+
+    void fastregrid_weights_destroy(fastregrid_weights *weights)
+    {
+        delete weights;
+    }
+
+    int fastregrid_weights_build(fastregrid_weights *weights,
+                                 const double *source_lons, const double *source_lats, int64_t n_source,
+                                 const double *target_lons, const double *target_lats, int64_t n_target,
+                                 const fastregrid_options *options)
+    {
+        if (!weights || !source_lons || !source_lats || !target_lons || !target_lats || n_source <= 0 || n_target < 0)
+        {
+            return fail(FASTREGRID_ERROR_INVALID_ARGUMENT, "Invalid weights handle or coordinate arrays");
+        }
+        return guarded([&]()
+                       {
+            fastregrid_options defaults;
+            fastregrid_default_options(&defaults);
+            const fastregrid::RegridConfig config = to_config(options ? *options : defaults);
+            weights->built = false;
+            weights->weights = fastregrid::RegridWeights::build(source_lons, source_lats, static_cast<size_t>(n_source),
+                                                                target_lons, target_lats, static_cast<size_t>(n_target),
+                                                                config);
+            weights->built = true; });
+    }
+
+    int64_t fastregrid_weights_source_size(const fastregrid_weights *weights)
+    {
+        return weights && weights->built ? static_cast<int64_t>(weights->weights.source_size()) : 0;
+    }
+
+    int64_t fastregrid_weights_target_size(const fastregrid_weights *weights)
+    {
+        return weights && weights->built ? static_cast<int64_t>(weights->weights.target_size()) : 0;
+    }
+
+    int fastregrid_weights_apply(const fastregrid_weights *weights,
+                                 const fastregrid_value_t *source_values, int64_t source_ld,
+                                 fastregrid_value_t *target_values, int64_t target_ld,
+                                 int64_t n_values)
+    {
+        if (!weights)
+        {
+            return fail(FASTREGRID_ERROR_INVALID_ARGUMENT, "Invalid weights handle");
+        }
+        if (!weights->built)
+        {
+            return fail(FASTREGRID_ERROR_NOT_BUILT, "Weights have not been built");
+        }
+        const fastregrid::RegridWeights &w = weights->weights;
+        if (!source_values || !target_values || n_values < 0 ||
+            source_ld < static_cast<int64_t>(w.source_size()) || target_ld < static_cast<int64_t>(w.target_size()))
+        {
+            return fail(FASTREGRID_ERROR_INVALID_ARGUMENT, "Invalid value arrays or leading dimensions");
+        }
+        return guarded([&]()
+                       { w.apply(source_values, 1, static_cast<size_t>(source_ld),
+                                 target_values, 1, static_cast<size_t>(target_ld),
+                                 static_cast<size_t>(n_values), 0, w.target_size()); });
+    }
+
+    const char *fastregrid_last_error(void)
+    {
+        return last_error.c_str();
+    }
+
+} // extern "C"
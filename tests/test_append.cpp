@@ -0,0 +1,104 @@
+// Appending the time steps missing from an output gives the rows of a full
+// run: in the same order when the new time steps come last in the target
+// file, as the same set of rows otherwise. Appending again writes nothing.
+
+#include "test_support.h"
+#include "../include/fastregrid/regridder.h"
+#include "../include/fastregrid/append.h"
+#include <algorithm>
+
+using namespace fastregrid;
+using namespace fastregrid_test;
+
+namespace
+{
+    RegridConfig make_config(const std::string &output_path)
+    {
+        RegridConfig config;
+        config.output_path = output_path;
+        config.interp_method = INVERSE_DISTANCE_WEIGHTED;
+        config.radius = 80.0;
+        config.min_points = 2;
+        config.max_points = 4;
+        config.write_mappings = false;
+        config.num_threads = 2;
+        return config;
+    }
+
+    std::vector<std::string> sorted_lines(const std::string &filename)
+    {
+        std::vector<std::string> lines = lines_of(read_file(filename));
+        std::sort(lines.begin(), lines.end());
+        return lines;
+    }
+}
+
+int main()
+{
+    const std::string dir = scratch_dir("append");
+    std::string source_file, target_file;
+    write_sample_grids(dir, source_file, target_file);
+    const size_t locations = 15 * 12;
+
+    // Years in file order: 2000-2001 for every location, then 2002
+    const std::string old_years = grid_by_time(80.1, 39.9, 0.37, 15, 12, 2000, 2, 2);
+    const std::string new_year = grid_by_time(80.1, 39.9, 0.37, 15, 12, 2002, 1, 3);
+    const std::string ordered_file = dir + "target_ordered.txt";
+    write_file(ordered_file, old_years + new_year.substr(new_year.find('\n') + 1));
+
+    const RegridConfig full_config = make_config(dir + "full/");
+    Regridder(source_file, ordered_file, full_config).regrid();
+
+    // Without an output, append() is a full run
+    const RegridConfig config = make_config(dir + "ordered/");
+    const std::string old_file = dir + "target_old.txt";
+    write_file(old_file, old_years);
+    CHECK(IncrementalRegridder(source_file, old_file, config).append() == 2 * locations);
+    CHECK(std::filesystem::exists(config.output_path + config.weights_file));
+
+    CHECK(IncrementalRegridder(source_file, ordered_file, config).append() == locations);
+    CHECK(read_file(config.output_path + "regridded.txt") == read_file(full_config.output_path + "regridded.txt"));
+    CHECK(read_file(config.output_path + "source_gridlist.txt") ==
+          read_file(full_config.output_path + "source_gridlist.txt"));
+    CHECK(read_file(config.output_path + "target_gridlist.txt") ==
+          read_file(full_config.output_path + "target_gridlist.txt"));
+
+    CHECK(IncrementalRegridder(source_file, ordered_file, config).append() == 0);
+    CHECK(read_file(config.output_path + "regridded.txt") == read_file(full_config.output_path + "regridded.txt"));
+
+    // Years interleaved per location: the appended rows follow the existing ones
+    const RegridConfig interleaved_full = make_config(dir + "interleaved_full/");
+    Regridder(source_file, target_file, interleaved_full).regrid();
+    const RegridConfig interleaved = make_config(dir + "interleaved/");
+    Regridder(source_file, old_file, interleaved).regrid();
+    CHECK(IncrementalRegridder(source_file, target_file, interleaved).append() == locations);
+    CHECK(sorted_lines(interleaved.output_path + "regridded.txt") ==
+          sorted_lines(interleaved_full.output_path + "regridded.txt"));
+
+    // Inputs with fewer columns than the existing output are rejected
+    auto drop_last_column = [&](const std::string &from, const std::string &to)
+    {
+        std::string text;
+        for (const std::string &line : lines_of(read_file(from)))
+        {
+            text += line.substr(0, line.rfind(' ')) + '\n';
+        }
+        write_file(to, text);
+    };
+    const std::string short_source = dir + "source_short.txt";
+    const std::string short_target = dir + "target_short.txt";
+    drop_last_column(source_file, short_source);
+    drop_last_column(target_file, short_target);
+    bool rejected = false;
+    try
+    {
+        IncrementalRegridder(short_source, short_target, interleaved).append();
+    }
+    catch (const std::runtime_error &)
+    {
+        rejected = true;
+    }
+    CHECK(rejected);
+
+    return result("test_append");
+}
@@ -0,0 +1,66 @@
+// A batch run builds one weight set per distinct pair of source and target
+// grids, and every job writes the same files as a standalone run. A failing
+// job does not stop the others.
+
+#include "test_support.h"
+#include "../include/fastregrid/regridder.h"
+#include "../include/fastregrid/batch.h"
+
+using namespace fastregrid;
+using namespace fastregrid_test;
+
+namespace
+{
+    RegridConfig make_config(const std::string &output_path)
+    {
+        RegridConfig config;
+        config.output_path = output_path;
+        config.interp_method = INVERSE_DISTANCE_WEIGHTED;
+        config.radius = 80.0;
+        config.min_points = 2;
+        config.max_points = 4;
+        config.write_mappings = false;
+        config.num_threads = 2;
+        return config;
+    }
+}
+
+int main()
+{
+    const std::string dir = scratch_dir("batch");
+    std::string source_file, target_file;
+    write_sample_grids(dir, source_file, target_file);
+
+    // A second variable on the source grid, and a coarser target grid
+    const std::string other_source = dir + "source_other.txt";
+    const std::string coarse_target = dir + "target_coarse.txt";
+    write_file(other_source, grid_by_time(80.0, 40.0, 0.5, 12, 10, 2000, 3, 11));
+    write_file(coarse_target, grid_by_time(80.3, 40.2, 0.9, 6, 5, 2000, 3, 12));
+
+    std::vector<BatchJob> jobs = {{source_file, target_file, dir + "job1/"},
+                                  {other_source, target_file, dir + "job2/"},
+                                  {source_file, coarse_target, dir + "job3/"},
+                                  {dir + "missing.txt", target_file, dir + "job4/"}};
+    BatchRunner runner(jobs, make_config(""), 2);
+    CHECK(runner.run() == 1);
+    CHECK(runner.weight_sets() == 2);
+    CHECK(runner.errors()[3].find("missing.txt") != std::string::npos);
+
+    for (size_t j = 0; j < 3; ++j)
+    {
+        CHECK(runner.errors()[j].empty());
+        const RegridConfig config = make_config(dir + "standalone" + std::to_string(j + 1) + "/");
+        Regridder(jobs[j].source_file, jobs[j].target_file, config).regrid();
+        for (const char *name : {"regridded.txt", "source_gridlist.txt", "target_gridlist.txt"})
+        {
+            CHECK(read_file(jobs[j].output_path + name) == read_file(config.output_path + name));
+        }
+    }
+
+    // Grids are read from locations alone, as a full parse would give them
+    const RegridConfig config = make_config("");
+    CHECK(Grid::load(source_file, config)->fingerprint() ==
+          Grid(InputReader(source_file, config).read_grid()).fingerprint());
+
+    return result("test_batch");
+}
@@ -0,0 +1,128 @@
+// The C interface builds the same weights as the C++ API, applies them to
+// column-major arrays, and reports invalid input through status codes.
+
+#include "test_support.h"
+#include "../include/fastregrid/fastregrid_c.h"
+#include "../include/fastregrid/weights.h"
+#include <cmath>
+#include <cstring>
+
+using namespace fastregrid;
+using namespace fastregrid_test;
+
+int main()
+{
+    // 6 x 5 source grid at 0.5 degree, targets between its points
+    std::vector<double> source_lons, source_lats, target_lons, target_lats;
+    for (int i = 0; i < 6; ++i)
+    {
+        for (int j = 0; j < 5; ++j)
+        {
+            source_lons.push_back(10.0 + 0.5 * i);
+            source_lats.push_back(45.0 + 0.5 * j);
+        }
+    }
+    for (int i = 0; i < 4; ++i)
+    {
+        for (int j = 0; j < 3; ++j)
+        {
+            target_lons.push_back(10.2 + 0.6 * i);
+            target_lats.push_back(45.1 + 0.7 * j);
+        }
+    }
+    const int64_t n_source = static_cast<int64_t>(source_lons.size());
+    const int64_t n_target = static_cast<int64_t>(target_lons.size());
+
+    fastregrid_options options;
+    fastregrid_default_options(&options);
+    options.interp_method = FASTREGRID_INVERSE_DISTANCE_WEIGHTED;
+    options.radius = 80.0;
+    options.min_points = 2;
+    options.max_points = 4;
+    options.num_threads = 2;
+
+    fastregrid_weights *weights = fastregrid_weights_create();
+    CHECK(weights != nullptr);
+    CHECK(fastregrid_weights_source_size(weights) == 0);
+
+    // Applying before building fails
+    std::vector<fastregrid_value_t> source_values(n_source * 2), target_values(n_target * 2, 0);
+    CHECK(fastregrid_weights_apply(weights, source_values.data(), n_source, target_values.data(), n_target, 2) ==
+          FASTREGRID_ERROR_NOT_BUILT);
+
+    CHECK(fastregrid_weights_build(weights, source_lons.data(), source_lats.data(), n_source, target_lons.data(),
+                                   target_lats.data(), n_target, &options) == FASTREGRID_OK);
+    CHECK(fastregrid_weights_source_size(weights) == n_source);
+    CHECK(fastregrid_weights_target_size(weights) == n_target);
+
+    // Two columns of a column-major (Fortran) array values(n_source, 2)
+    for (int64_t i = 0; i < n_source; ++i)
+    {
+        source_values[i] = static_cast<fastregrid_value_t>(i);
+        source_values[n_source + i] = static_cast<fastregrid_value_t>(100.0 + 3.0 * source_lats[i]);
+    }
+    CHECK(fastregrid_weights_apply(weights, source_values.data(), n_source, target_values.data(), n_target, 2) ==
+          FASTREGRID_OK);
+
+    // Same as the C++ weights, applied row by row
+    RegridConfig config;
+    config.interp_method = INVERSE_DISTANCE_WEIGHTED;
+    config.radius = options.radius;
+    config.power = options.power;
+    config.min_points = options.min_points;
+    config.max_points = options.max_points;
+    config.num_threads = 2;
+    const RegridWeights expected = RegridWeights::build(source_lons.data(), source_lats.data(), n_source,
+                                                        target_lons.data(), target_lats.data(), n_target, config);
+    std::vector<ValueType> rows(n_source * 2), expected_rows(n_target * 2);
+    for (int64_t i = 0; i < n_source; ++i)
+    {
+        rows[i * 2] = source_values[i];
+        rows[i * 2 + 1] = source_values[n_source + i];
+    }
+    expected.apply(rows.data(), 2, expected_rows.data(), 2, 2);
+    for (int64_t t = 0; t < n_target; ++t)
+    {
+        CHECK(target_values[t] == expected_rows[t * 2]);
+        CHECK(target_values[n_target + t] == expected_rows[t * 2 + 1]);
+        // A column linear in latitude stays within the range of its sources
+        CHECK(target_values[n_target + t] >= 100.0 + 3.0 * 45.0 - 1e-9);
+        CHECK(target_values[n_target + t] <= 100.0 + 3.0 * 47.0 + 1e-9);
+    }
+
+    // Nearest neighbour onto the source grid itself reproduces the source
+    fastregrid_options nearest = options;
+    nearest.interp_method = FASTREGRID_NEAREST_NEIGHBOR;
+    CHECK(fastregrid_weights_build(weights, source_lons.data(), source_lats.data(), n_source, source_lons.data(),
+                                   source_lats.data(), n_source, &nearest) == FASTREGRID_OK);
+    std::vector<fastregrid_value_t> copy(n_source * 2, 0);
+    CHECK(fastregrid_weights_apply(weights, source_values.data(), n_source, copy.data(), n_source, 2) == FASTREGRID_OK);
+    CHECK(copy == source_values);
+
+    // Invalid options are rejected with a message, keeping the previous weights
+    for (double power : {0.0, -2.0, std::nan("")})
+    {
+        fastregrid_options invalid = options;
+        invalid.power = power;
+        CHECK(fastregrid_weights_build(weights, source_lons.data(), source_lats.data(), n_source, target_lons.data(),
+                                       target_lats.data(), n_target, &invalid) == FASTREGRID_ERROR_INVALID_ARGUMENT);
+        CHECK(std::strlen(fastregrid_last_error()) > 0);
+    }
+    fastregrid_options invalid = options;
+    invalid.min_points = 5;
+    CHECK(fastregrid_weights_build(weights, source_lons.data(), source_lats.data(), n_source, target_lons.data(),
+                                   target_lats.data(), n_target, &invalid) == FASTREGRID_ERROR_INVALID_ARGUMENT);
+    invalid = options;
+    invalid.interp_method = 7;
+    CHECK(fastregrid_weights_build(weights, source_lons.data(), source_lats.data(), n_source, target_lons.data(),
+                                   target_lats.data(), n_target, &invalid) == FASTREGRID_ERROR_INVALID_ARGUMENT);
+    CHECK(fastregrid_weights_target_size(weights) == n_source);
+    CHECK(fastregrid_weights_apply(weights, source_values.data(), n_source - 1, copy.data(), n_source, 2) ==
+          FASTREGRID_ERROR_INVALID_ARGUMENT);
+    CHECK(fastregrid_weights_apply(nullptr, source_values.data(), n_source, copy.data(), n_source, 2) ==
+          FASTREGRID_ERROR_INVALID_ARGUMENT);
+
+    fastregrid_weights_destroy(weights);
+    fastregrid_weights_destroy(nullptr);
+    return result("test_c_api");
+}
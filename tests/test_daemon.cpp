@@ -0,0 +1,148 @@
+// The daemon answers REGRID requests over its socket with the output of a
+// file regrid, as files or in shared memory, serves repeated jobs from its
+// cache, reports errors as ERROR responses and stops on SHUTDOWN.
+
+#include "test_support.h"
+#include "../include/fastregrid/regridder.h"
+#include "../include/fastregrid/daemon.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+using namespace fastregrid;
+using namespace fastregrid_test;
+
+namespace
+{
+    bool starts_with(const std::string &text, const std::string &prefix)
+    {
+        return text.compare(0, prefix.size(), prefix) == 0;
+    }
+
+    bool has_line(const std::string &response, const std::string &line)
+    {
+        const std::vector<std::string> lines = lines_of(response);
+        return std::find(lines.begin(), lines.end(), line) != lines.end();
+    }
+}
+
+int main()
+{
+    const std::string dir = scratch_dir("daemon");
+    std::string source_file, target_file;
+    write_sample_grids(dir, source_file, target_file);
+    const size_t rows = 15 * 12 * 3;
+
+    RegridConfig config;
+    config.output_path = dir + "reference/";
+    config.interp_method = INVERSE_DISTANCE_WEIGHTED;
+    config.radius = 80.0;
+    config.min_points = 2;
+    config.max_points = 4;
+    config.write_mappings = false;
+    config.num_threads = 2;
+    Regridder(source_file, target_file, config).regrid();
+
+    const std::string socket_path = dir + "fastregridd.sock";
+    RegridDaemon daemon(socket_path, config);
+    std::thread server([&daemon]()
+                       { daemon.serve(); });
+    auto request = [&](const std::string &payload)
+    {
+        return protocol::request(socket_path, payload);
+    };
+    bool listening = false;
+    for (int attempt = 0; attempt < 500 && !listening; ++attempt)
+    {
+        try
+        {
+            listening = request("PING") == "OK\n";
+        }
+        catch (const std::runtime_error &)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    CHECK(listening);
+
+    // A job writes the files of a file regrid; repeating it reuses the cached weights
+    const std::string job = "REGRID\nsource=" + source_file + "\ntarget=" + target_file + "\nmethod=idw\n";
+    for (const char *cache : {"cache=miss", "cache=hit"})
+    {
+        const std::string output_path = dir + (cache[6] == 'm' ? "first/" : "second/");
+        const std::string response = request(job + "output=" + output_path + "\n");
+        CHECK(starts_with(response, "OK\n"));
+        CHECK(has_line(response, "rows=" + std::to_string(rows)));
+        CHECK(has_line(response, "stride=12"));
+        CHECK(has_line(response, cache));
+        CHECK(read_file(output_path + "regridded.txt") == read_file(config.output_path + "regridded.txt"));
+        CHECK(read_file(output_path + "target_gridlist.txt") == read_file(config.output_path + "target_gridlist.txt"));
+    }
+
+    // Other search settings need other weights
+    CHECK(has_line(request(job + "method=nn\noutput=" + dir + "nn/\n"), "cache=miss"));
+
+    // Results in shared memory hold the rows of the file, unrounded
+    const std::string shm_name = "/fastregrid_test_" + std::to_string(getpid());
+    const std::string shm_response = request(job + "shm=" + shm_name + "\n");
+    CHECK(starts_with(shm_response, "OK\n"));
+    int fd = shm_open(shm_name.c_str(), O_RDONLY, 0);
+    CHECK(fd >= 0);
+    if (fd >= 0)
+    {
+        struct stat info;
+        fstat(fd, &info);
+        void *addr = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        shm_unlink(shm_name.c_str());
+        CHECK(addr != MAP_FAILED);
+        if (addr != MAP_FAILED)
+        {
+            const char *data = static_cast<const char *>(addr);
+            protocol::ShmHeader header;
+            std::memcpy(&header, data, sizeof(header));
+            CHECK(header.magic == protocol::SHM_MAGIC);
+            CHECK(header.rows == rows && header.stride == 12 && header.value_bytes == sizeof(ValueType));
+            const char *values = data + sizeof(header) + rows * (2 * sizeof(double) + sizeof(int64_t));
+            const std::vector<std::string> lines = lines_of(read_file(config.output_path + "regridded.txt"));
+            for (size_t i = 0; i + 1 < lines.size() && i < rows; ++i)
+            {
+                std::istringstream row(lines[i + 1]);
+                double lon = 0, lat = 0, year = 0;
+                row >> lon >> lat >> year;
+                for (size_t j = 0; j < 12; ++j)
+                {
+                    double expected = 0;
+                    row >> expected;
+                    ValueType value;
+                    std::memcpy(&value, values + (i * 12 + j) * sizeof(ValueType), sizeof(ValueType));
+                    CHECK(std::abs(value - expected) <= 1e-4);
+                }
+            }
+            munmap(addr, static_cast<size_t>(info.st_size));
+        }
+    }
+
+    // Bad requests get an ERROR response and leave the daemon serving
+    for (const std::string &bad : {std::string("FETCH\n"), "REGRID\ntarget=" + target_file + "\noutput=" + dir + "x/\n",
+                                   job + "output=" + dir + "x/\nshm=/x\n", job + "method=bilinear\noutput=" + dir + "x/\n",
+                                   job + "min_points=5\noutput=" + dir + "x/\n", std::string("REGRID\nsource\n")})
+    {
+        CHECK(starts_with(request(bad), "ERROR\n"));
+    }
+    const std::string stats = request("STATS");
+    CHECK(starts_with(stats, "OK\n"));
+    // Eight REGRID requests reached the handler (the last bad one is not parsed);
+    // the parsed target was reused three times and the idw weights twice
+    CHECK(has_line(stats, "requests=8"));
+    CHECK(has_line(stats, "entries=3"));
+    CHECK(has_line(stats, "hits=5"));
+    CHECK(has_line(stats, "misses=3"));
+
+    CHECK(request("SHUTDOWN") == "OK\n");
+    server.join();
+    CHECK(!std::filesystem::exists(socket_path));
+
+    return result("test_daemon");
+}
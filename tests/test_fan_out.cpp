@@ -0,0 +1,61 @@
+// One fan-out pass over several targets writes, for every target, the same
+// files as a standalone run onto that target alone, mapping files included.
+
+#include "test_support.h"
+#include "../include/fastregrid/regridder.h"
+
+using namespace fastregrid;
+using namespace fastregrid_test;
+
+int main()
+{
+    const std::string dir = scratch_dir("fan_out");
+    std::string source_file, target_file;
+    write_sample_grids(dir, source_file, target_file);
+
+    // A coarser grid, and one partly outside the source area with a single year
+    const std::string coarse_target = dir + "target_coarse.txt";
+    const std::string offset_target = dir + "target_offset.txt";
+    write_file(coarse_target, grid_by_time(80.3, 40.2, 0.9, 6, 5, 2000, 3, 12));
+    write_file(offset_target, grid_by_time(83.05, 42.05, 0.6, 8, 7, 2001, 1, 13));
+    const std::vector<std::string> target_files = {target_file, coarse_target, offset_target};
+
+    for (InterpolationMethod method : {NEAREST_NEIGHBOR, INVERSE_DISTANCE_WEIGHTED})
+    {
+        const std::string name = method == NEAREST_NEIGHBOR ? "nn" : "idw";
+        RegridConfig config;
+        config.interp_method = method;
+        config.radius = 60.0;
+        config.min_points = 2;
+        config.max_points = 4;
+        config.write_mappings = true;
+        config.num_threads = 2;
+        config.chunk_size = 100; // Several pipeline chunks per target
+
+        std::vector<RegridTarget> targets;
+        for (size_t i = 0; i < target_files.size(); ++i)
+        {
+            targets.push_back({target_files[i], dir + name + "_fan_out_" + std::to_string(i) + "/"});
+        }
+        config.output_path = targets[0].output_path;
+        const RegridStats fan_out = Regridder(source_file, targets, config).regrid();
+
+        uint64_t rows_written = 0;
+        for (size_t i = 0; i < target_files.size(); ++i)
+        {
+            config.output_path = dir + name + "_standalone_" + std::to_string(i) + "/";
+            rows_written += Regridder(source_file, target_files[i], config).regrid().rows_written;
+            size_t files = 0;
+            for (const auto &entry : std::filesystem::directory_iterator(config.output_path))
+            {
+                const std::string file = entry.path().filename().string();
+                CHECK(read_file(targets[i].output_path + file) == read_file(config.output_path + file));
+                ++files;
+            }
+            CHECK(files == 5); // regridded.txt, two gridlists, two mapping files
+        }
+        CHECK(fan_out.rows_written == rows_written);
+    }
+
+    return result("test_fan_out");
+}
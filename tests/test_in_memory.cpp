@@ -0,0 +1,88 @@
+// In-memory regridding over caller buffers gives the values a file regrid
+// writes, with all time steps of a location laid out within one stride.
+
+#include "test_support.h"
+#include "../include/fastregrid/regridder.h"
+#include <cmath>
+
+using namespace fastregrid;
+using namespace fastregrid_test;
+
+namespace
+{
+    const size_t MONTHS = 12;
+    const size_t YEARS = 3;
+    const size_t STRIDE = MONTHS * YEARS;
+    const double TOLERANCE = sizeof(ValueType) == sizeof(float) ? 1e-4 : 1e-6;
+}
+
+int main()
+{
+    const std::string dir = scratch_dir("in_memory");
+    std::string source_file, target_file;
+    write_sample_grids(dir, source_file, target_file);
+
+    std::vector<double> source_lons, source_lats, target_lons, target_lats;
+    std::vector<ValueType> source_values, unused;
+    read_grid_by_location(source_file, YEARS, source_lons, source_lats, source_values);
+    read_grid_by_location(target_file, YEARS, target_lons, target_lats, unused);
+    CHECK(source_values.size() == source_lons.size() * STRIDE);
+
+    for (InterpolationMethod method : {NEAREST_NEIGHBOR, INVERSE_DISTANCE_WEIGHTED})
+    {
+        RegridConfig config;
+        config.output_path = dir + (method == NEAREST_NEIGHBOR ? "nn/" : "idw/");
+        config.interp_method = method;
+        config.radius = 80.0;
+        config.min_points = 2;
+        config.max_points = 4;
+        config.precision = 6; // Keeps lon and lat within their 10-character columns
+        config.write_mappings = false;
+        config.num_threads = 2;
+        Regridder(source_file, target_file, config).regrid();
+
+        std::vector<ValueType> target_values(target_lons.size() * STRIDE);
+        Regridder::regrid(source_lons, source_lats, source_values.data(), STRIDE, target_lons, target_lats,
+                          target_values.data(), STRIDE, STRIDE, config);
+
+        // Row r of the output is year r % YEARS of target location r / YEARS
+        const std::vector<std::string> lines = lines_of(read_file(config.output_path + "regridded.txt"));
+        CHECK(lines.size() == target_lons.size() * YEARS + 1);
+        for (size_t i = 1; i < lines.size(); ++i)
+        {
+            std::istringstream row(lines[i]);
+            double lon = 0, lat = 0;
+            int year = 0;
+            row >> lon >> lat >> year;
+            const ValueType *values = target_values.data() + (i - 1) * MONTHS;
+            for (size_t month = 0; month < MONTHS; ++month)
+            {
+                double value = 0;
+                row >> value;
+                CHECK(std::abs(values[month] - value) <= TOLERANCE);
+            }
+        }
+    }
+
+    // Mismatched arrays and counts beyond the stride are rejected
+    RegridConfig config;
+    std::vector<ValueType> target_values(target_lons.size() * STRIDE);
+    auto rejects = [&](Span<const double> lats, size_t count)
+    {
+        try
+        {
+            Regridder::regrid(source_lons, lats, source_values.data(), STRIDE, target_lons, target_lats,
+                              target_values.data(), STRIDE, count, config);
+        }
+        catch (const std::invalid_argument &)
+        {
+            return true;
+        }
+        return false;
+    };
+    CHECK(rejects(Span<const double>(source_lats.data(), source_lats.size() - 1), STRIDE));
+    CHECK(rejects(source_lats, STRIDE + 1));
+    CHECK(!rejects(source_lats, STRIDE));
+
+    return result("test_in_memory");
+}
@@ -0,0 +1,85 @@
+// PointQuery gives the values a file regrid writes for the same target rows,
+// for both methods and metrics, one point at a time or in batches.
+
+#include "test_support.h"
+#include "../include/fastregrid/regridder.h"
+#include "../include/fastregrid/query.h"
+#include <cmath>
+
+using namespace fastregrid;
+using namespace fastregrid_test;
+
+namespace
+{
+    // Written values have config.precision decimals; float builds also round values
+    const double TOLERANCE = sizeof(ValueType) == sizeof(float) ? 1e-4 : 1e-6;
+
+    void check_parity(const std::string &dir, const std::string &source_file, const std::string &target_file,
+                      InterpolationMethod method, DistanceMetric metric)
+    {
+        RegridConfig config;
+        config.output_path = dir + (method == NEAREST_NEIGHBOR ? "nn_" : "idw_") +
+                             (metric == HAVERSINE ? "haversine/" : "euclidean/");
+        config.interp_method = method;
+        config.distance_metric = metric;
+        config.radius = 80.0;
+        config.min_points = 2;
+        config.max_points = 4;
+        config.precision = 6; // Keeps lon and lat within their 10-character columns
+        config.write_mappings = false;
+        config.num_threads = 2;
+        Regridder(source_file, target_file, config).regrid();
+
+        const PointQuery query(source_file, config);
+        const std::vector<std::string> lines = lines_of(read_file(config.output_path + "regridded.txt"));
+        CHECK(lines.size() > 1);
+        std::vector<double> lons, lats, expected;
+        std::vector<int> years;
+        std::vector<ValueType> values(query.stride());
+        for (size_t i = 1; i < lines.size(); ++i)
+        {
+            std::istringstream row(lines[i]);
+            double lon = 0, lat = 0, year = 0;
+            row >> lon >> lat >> year;
+            lons.push_back(lon);
+            lats.push_back(lat);
+            years.push_back(static_cast<int>(year));
+            CHECK(query.query(lon, lat, static_cast<int>(year), values.data()));
+            for (size_t j = 0; j < query.stride(); ++j)
+            {
+                double value = 0;
+                row >> value;
+                expected.push_back(value);
+                CHECK(std::abs(values[j] - value) <= TOLERANCE);
+            }
+        }
+
+        // Batch form, on the thread pool
+        std::vector<ValueType> batch(lons.size() * query.stride());
+        std::vector<uint8_t> found(lons.size());
+        CHECK(query.query(lons.data(), lats.data(), years.data(), lons.size(), batch.data(), found.data()) == lons.size());
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            CHECK(std::abs(batch[i] - expected[i]) <= TOLERANCE);
+        }
+
+        // No source has this time step
+        CHECK(!query.query(lons[0], lats[0], 1999, values.data()));
+    }
+}
+
+int main()
+{
+    const std::string dir = scratch_dir("point_query");
+    std::string source_file, target_file;
+    write_sample_grids(dir, source_file, target_file);
+
+    for (InterpolationMethod method : {NEAREST_NEIGHBOR, INVERSE_DISTANCE_WEIGHTED})
+    {
+        for (DistanceMetric metric : {HAVERSINE, EUCLIDEAN})
+        {
+            check_parity(dir, source_file, target_file, method, metric);
+        }
+    }
+    return result("test_point_query");
+}
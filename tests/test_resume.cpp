@@ -0,0 +1,105 @@
+// Resuming an interrupted streaming run from its checkpoint gives the same
+// outputs as an uninterrupted run, with and without mapping files.
+
+#include "test_support.h"
+#include "../include/fastregrid/regridder.h"
+#include "../include/fastregrid/checkpoint.h"
+
+using namespace fastregrid;
+using namespace fastregrid_test;
+
+namespace
+{
+    const size_t CHUNK_ROWS = 37;
+    const size_t CHUNKS_DONE = 5; // Chunks completed before the simulated interruption
+
+    RegridConfig make_config(const std::string &output_path, bool write_mappings)
+    {
+        RegridConfig config;
+        config.output_path = output_path;
+        config.interp_method = INVERSE_DISTANCE_WEIGHTED;
+        config.radius = 80.0;
+        config.min_points = 2;
+        config.max_points = 4;
+        config.write_mappings = write_mappings;
+        config.chunk_size = CHUNK_ROWS;
+        config.num_threads = 2;
+        return config;
+    }
+
+    void check_resume(const std::string &dir, const std::string &source_file, const std::string &target_file,
+                      bool write_mappings)
+    {
+        const std::string name = write_mappings ? "mappings" : "no_mappings";
+        const std::vector<std::string> outputs = write_mappings
+                                                     ? std::vector<std::string>{"regridded.txt", "nn_mappings.txt", "idw_mappings.txt"}
+                                                     : std::vector<std::string>{"regridded.txt"};
+
+        // Uninterrupted run
+        const std::string full_dir = dir + name + "_full/";
+        Regridder(source_file, target_file, make_config(full_dir, write_mappings)).regrid();
+
+        // The outputs at a checkpoint after CHUNKS_DONE chunks are those of a run
+        // over just their target rows
+        const std::vector<std::string> target_lines = lines_of(read_file(target_file));
+        std::string prefix;
+        for (size_t i = 0; i <= CHUNKS_DONE * CHUNK_ROWS; ++i)
+        {
+            prefix += target_lines[i] + '\n';
+        }
+        const std::string prefix_file = dir + name + "_prefix.txt";
+        write_file(prefix_file, prefix);
+        const std::string resumed_dir = dir + name + "_resumed/";
+        Regridder(source_file, prefix_file, make_config(resumed_dir, write_mappings)).regrid();
+
+        RegridConfig config = make_config(resumed_dir, write_mappings);
+        config.checkpoint_interval = 1;
+        Checkpoint checkpoint;
+        checkpoint.source = FileStamp::of(source_file);
+        checkpoint.target = FileStamp::of(target_file);
+        checkpoint.settings = Checkpoint::settings_of(config);
+        checkpoint.next_row = CHUNKS_DONE * CHUNK_ROWS;
+        checkpoint.rows_written = CHUNKS_DONE * CHUNK_ROWS;
+        checkpoint.data_bytes = read_file(resumed_dir + "regridded.txt").size();
+        if (write_mappings)
+        {
+            checkpoint.nn_bytes = read_file(resumed_dir + "nn_mappings.txt").size();
+            checkpoint.idw_bytes = read_file(resumed_dir + "idw_mappings.txt").size();
+        }
+        checkpoint.save(resumed_dir + config.checkpoint_file);
+
+        // Rows written after the checkpoint, before the interruption, are discarded
+        for (const auto &output : outputs)
+        {
+            std::ofstream(resumed_dir + output, std::ios::app) << "partial row written after the checkpoint\n";
+        }
+
+        bool resumed = true;
+        try
+        {
+            Regridder(source_file, target_file, config).regrid();
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << name << ": resume failed: " << e.what() << std::endl;
+            resumed = false;
+        }
+        CHECK(resumed);
+        for (const auto &output : outputs)
+        {
+            CHECK(read_file(resumed_dir + output) == read_file(full_dir + output));
+        }
+        CHECK(!std::filesystem::exists(resumed_dir + config.checkpoint_file));
+    }
+}
+
+int main()
+{
+    const std::string dir = scratch_dir("resume");
+    std::string source_file, target_file;
+    write_sample_grids(dir, source_file, target_file);
+
+    check_resume(dir, source_file, target_file, false);
+    check_resume(dir, source_file, target_file, true);
+    return result("test_resume");
+}
@@ -0,0 +1,131 @@
+// One RegridSession serves apply() calls from several threads at once: every
+// call reuses the session's grids, index and weights and gives the values a
+// file regrid writes.
+
+#include "test_support.h"
+#include "../include/fastregrid/regridder.h"
+#include "../include/fastregrid/session.h"
+#include <cmath>
+#include <thread>
+
+using namespace fastregrid;
+using namespace fastregrid_test;
+
+namespace
+{
+    const size_t MONTHS = 12;
+    const size_t YEARS = 3;
+    const size_t STRIDE = MONTHS * YEARS;
+    const size_t THREADS = 6;
+    const double TOLERANCE = sizeof(ValueType) == sizeof(float) ? 1e-4 : 1e-6;
+
+    // Weights as plain arrays, to check that apply() leaves them untouched.
+    std::vector<double> snapshot(const RegridWeights &weights)
+    {
+        std::vector<double> entries;
+        for (size_t t = 0; t < weights.target_size(); ++t)
+        {
+            entries.push_back(static_cast<double>(weights.begin(t)));
+            entries.push_back(weights.fallback(t) ? 1.0 : 0.0);
+        }
+        for (size_t e = 0; e < weights.nonzeros(); ++e)
+        {
+            entries.push_back(static_cast<double>(weights.source(e)));
+            entries.push_back(weights.weight(e));
+        }
+        return entries;
+    }
+}
+
+int main()
+{
+    const std::string dir = scratch_dir("session");
+    std::string source_file, target_file;
+    write_sample_grids(dir, source_file, target_file);
+
+    std::vector<double> source_lons, source_lats, target_lons, target_lats;
+    std::vector<ValueType> source_values, unused;
+    read_grid_by_location(source_file, YEARS, source_lons, source_lats, source_values);
+    read_grid_by_location(target_file, YEARS, target_lons, target_lats, unused);
+
+    for (InterpolationMethod method : {NEAREST_NEIGHBOR, INVERSE_DISTANCE_WEIGHTED})
+    {
+        RegridConfig config;
+        config.output_path = dir + (method == NEAREST_NEIGHBOR ? "nn/" : "idw/");
+        config.interp_method = method;
+        config.radius = 80.0;
+        config.min_points = 2;
+        config.max_points = 4;
+        config.precision = 6; // Keeps lon and lat within their 10-character columns
+        config.write_mappings = false;
+        config.num_threads = 2;
+        Regridder(source_file, target_file, config).regrid();
+
+        // Expected values in session order: location-major, then year and month
+        std::vector<double> expected;
+        for (const std::string &line : lines_of(read_file(config.output_path + "regridded.txt")))
+        {
+            std::istringstream row(line);
+            double lon = 0, lat = 0, year = 0, value = 0;
+            if (row >> lon >> lat >> year)
+            {
+                while (row >> value)
+                {
+                    expected.push_back(value);
+                }
+            }
+        }
+
+        const RegridSession session(source_file, target_file, config);
+        CHECK(session.source_size() == source_lons.size());
+        CHECK(session.target_size() == target_lons.size());
+        CHECK(expected.size() == session.target_size() * STRIDE);
+        const SpatialIndex *index = &session.index();
+        const double *target_coordinates = session.target_grid().longitudes().data();
+        const std::vector<double> weights = snapshot(session.weights());
+
+        // Each thread regrids all years at once or one year at a time, several times over
+        std::vector<std::vector<ValueType>> results(THREADS, std::vector<ValueType>(session.target_size() * STRIDE));
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < THREADS; ++i)
+        {
+            threads.emplace_back([&, i]()
+                                 {
+                for (int round = 0; round < 3; ++round)
+                {
+                    if (i % 2 == 0)
+                    {
+                        session.apply(source_values.data(), STRIDE, results[i].data(), STRIDE, STRIDE);
+                        continue;
+                    }
+                    for (size_t year = 0; year < YEARS; ++year)
+                    {
+                        session.apply(source_values.data() + year * MONTHS, STRIDE, results[i].data() + year * MONTHS,
+                                      STRIDE, MONTHS);
+                    }
+                } });
+        }
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+
+        for (const std::vector<ValueType> &result : results)
+        {
+            for (size_t k = 0; k < expected.size() && k < result.size(); ++k)
+            {
+                CHECK(std::abs(result[k] - expected[k]) <= TOLERANCE);
+            }
+            CHECK(result == results[0]);
+        }
+        CHECK(&session.index() == index);
+        CHECK(session.target_grid().longitudes().data() == target_coordinates);
+        CHECK(snapshot(session.weights()) == weights);
+
+        // A session over coordinate arrays builds the same weights
+        const RegridSession from_arrays(source_lons, source_lats, target_lons, target_lats, config);
+        CHECK(snapshot(from_arrays.weights()) == weights);
+    }
+
+    return result("test_session");
+}
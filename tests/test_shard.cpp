@@ -0,0 +1,68 @@
+// A sharded run (prepare, one run per shard, merge) writes the same
+// regridded.txt as a single run, and each shard keeps only the source values
+// at its own time steps.
+
+#include "test_support.h"
+#include "../include/fastregrid/regridder.h"
+#include "../include/fastregrid/shard.h"
+
+using namespace fastregrid;
+using namespace fastregrid_test;
+
+namespace
+{
+    RegridConfig make_config(const std::string &output_path)
+    {
+        RegridConfig config;
+        config.output_path = output_path;
+        config.interp_method = INVERSE_DISTANCE_WEIGHTED;
+        config.radius = 80.0;
+        config.min_points = 2;
+        config.max_points = 4;
+        config.write_mappings = false;
+        config.num_threads = 2;
+        return config;
+    }
+}
+
+int main()
+{
+    const std::string dir = scratch_dir("shard");
+    std::string source_file, target_file;
+    write_sample_grids(dir, source_file, target_file);
+
+    const RegridConfig full_config = make_config(dir + "full/");
+    Regridder(source_file, target_file, full_config).regrid();
+
+    for (size_t num_shards : {1, 3, 7})
+    {
+        const RegridConfig config = make_config(dir + "shards" + std::to_string(num_shards) + "/");
+        ShardedRegrid sharded(source_file, target_file, config);
+        const size_t rows = sharded.prepare();
+        size_t rows_written = 0;
+        for (size_t shard = 0; shard < num_shards; ++shard)
+        {
+            rows_written += sharded.run(shard, num_shards);
+        }
+        sharded.merge(num_shards);
+        CHECK(rows_written == rows);
+        CHECK(read_file(config.output_path + "regridded.txt") == read_file(full_config.output_path + "regridded.txt"));
+        CHECK(read_file(config.output_path + "target_gridlist.txt") ==
+              read_file(full_config.output_path + "target_gridlist.txt"));
+        CHECK(!std::filesystem::exists(config.output_path + ShardedRegrid::part_file(0, num_shards)));
+    }
+
+    // The source of a shard covering one year holds that year only, on the full grid
+    const Field all_years = Field::load(source_file, full_config);
+    const Field one_year = Field::load(source_file, full_config, std::unordered_set<int>{2001});
+    CHECK(all_years.time_steps().size() == 3);
+    CHECK(one_year.time_steps() == std::vector<int>{2001});
+    CHECK(one_year.grid().fingerprint() == all_years.grid().fingerprint());
+    const size_t year = all_years.time_index(2001);
+    for (size_t location = 0; location < all_years.grid().size(); ++location)
+    {
+        CHECK(one_year.has(0, location) == all_years.has(year, location));
+        CHECK(one_year.values(0, location)[0] == all_years.values(year, location)[0]);
+    }
+    return result("test_shard");
+}
@@ -0,0 +1,105 @@
+// Source values over the memory budget are spilled to a file: the spilled
+// field holds the values of an in-memory one, and runs under the budget write
+// the files of runs without it.
+
+#include "test_support.h"
+#include "../include/fastregrid/regridder.h"
+#include <cstring>
+
+using namespace fastregrid;
+using namespace fastregrid_test;
+
+namespace
+{
+    bool same_values(const Field &a, const Field &b)
+    {
+        if (a.grid().fingerprint() != b.grid().fingerprint() || a.time_steps() != b.time_steps() ||
+            a.stride() != b.stride())
+        {
+            return false;
+        }
+        for (size_t t = 0; t < a.time_steps().size(); ++t)
+        {
+            for (size_t location = 0; location < a.grid().size(); ++location)
+            {
+                if (a.has(t, location) != b.has(t, location) ||
+                    (a.has(t, location) &&
+                     std::memcmp(a.values(t, location), b.values(t, location), a.stride() * sizeof(ValueType)) != 0))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+int main()
+{
+    const std::string dir = scratch_dir("spill");
+    std::string source_file, target_file;
+    write_sample_grids(dir, source_file, target_file);
+    const std::string spill_dir = dir + "spill/";
+    std::filesystem::create_directories(spill_dir);
+
+    // A source with gaps: every seventh row is missing
+    const std::string sparse_file = dir + "source_sparse.txt";
+    std::string sparse_text;
+    const std::vector<std::string> lines = lines_of(read_file(source_file));
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        if (i == 0 || i % 7 != 0)
+        {
+            sparse_text += lines[i] + '\n';
+        }
+    }
+    write_file(sparse_file, sparse_text);
+
+    // 120 locations x 3 years x 12 values are well over 4 KiB
+    RegridConfig config;
+    config.spill_path = spill_dir;
+    for (const std::string &file : {source_file, sparse_file})
+    {
+        config.memory_budget = 0;
+        const Field in_memory = Field::load(file, config);
+        config.memory_budget = size_t(1) << 30;
+        const Field within_budget = Field::load(file, config);
+        config.memory_budget = 4096;
+        const Field spilled = Field::load(file, config);
+        CHECK(!in_memory.spilled());
+        CHECK(!within_budget.spilled());
+        CHECK(spilled.spilled());
+        CHECK(same_values(spilled, in_memory));
+        CHECK(same_values(within_budget, in_memory));
+    }
+
+    for (InterpolationMethod method : {NEAREST_NEIGHBOR, INVERSE_DISTANCE_WEIGHTED})
+    {
+        const std::string name = method == NEAREST_NEIGHBOR ? "nn" : "idw";
+        config.interp_method = method;
+        config.radius = 80.0;
+        config.min_points = 2;
+        config.max_points = 4;
+        config.write_mappings = true;
+        config.num_threads = 2;
+        config.chunk_size = 100; // Several pipeline chunks, each visited in Z-order
+
+        config.memory_budget = 0;
+        config.output_path = dir + name + "_in_memory/";
+        Regridder(source_file, target_file, config).regrid();
+        config.memory_budget = 4096;
+        config.output_path = dir + name + "_spilled/";
+        Regridder(source_file, target_file, config).regrid();
+
+        for (const char *file : {"regridded.txt", "source_gridlist.txt", "target_gridlist.txt", "nn_mappings.txt",
+                                 "idw_mappings.txt"})
+        {
+            CHECK(read_file(dir + name + "_spilled/" + file) == read_file(dir + name + "_in_memory/" + file));
+        }
+    }
+
+    // Spill files are unlinked on creation and leave nothing behind
+    CHECK(std::filesystem::is_empty(spill_dir));
+
+    return result("test_spill");
+}
@@ -0,0 +1,202 @@
+// Run statistics count what a run did on a sample small enough to count by
+// hand, and the stats file is valid JSON with the same numbers.
+
+#include "test_support.h"
+#include "../include/fastregrid/regridder.h"
+#include <cctype>
+#include <cstdlib>
+#include <map>
+
+using namespace fastregrid;
+using namespace fastregrid_test;
+
+namespace
+{
+    // Minimal JSON reader: objects, numbers and literals, as written by
+    // RegridStats::to_json(). Flattens values into keys like "stages.total.cpu_seconds";
+    // ok is false if the text is not valid JSON of that kind.
+    class FlatJson
+    {
+    public:
+        explicit FlatJson(const std::string &text) : text_(text)
+        {
+            ok = value("") && (skip_space(), pos_ == text_.size());
+        }
+
+        bool ok = false;
+        std::map<std::string, std::string> values;
+
+    private:
+        void skip_space()
+        {
+            while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_])))
+            {
+                ++pos_;
+            }
+        }
+
+        bool consume(char c)
+        {
+            skip_space();
+            if (pos_ < text_.size() && text_[pos_] == c)
+            {
+                ++pos_;
+                return true;
+            }
+            return false;
+        }
+
+        bool string(std::string &out)
+        {
+            if (!consume('"'))
+            {
+                return false;
+            }
+            const size_t end = text_.find('"', pos_);
+            if (end == std::string::npos)
+            {
+                return false;
+            }
+            out = text_.substr(pos_, end - pos_);
+            pos_ = end + 1;
+            return true;
+        }
+
+        bool value(const std::string &key)
+        {
+            skip_space();
+            if (consume('{'))
+            {
+                if (consume('}'))
+                {
+                    return true;
+                }
+                do
+                {
+                    std::string name;
+                    if (!string(name) || !consume(':') || !value(key.empty() ? name : key + "." + name))
+                    {
+                        return false;
+                    }
+                } while (consume(','));
+                return consume('}');
+            }
+            const size_t start = pos_;
+            while (pos_ < text_.size() && (std::isalnum(static_cast<unsigned char>(text_[pos_])) ||
+                                           text_[pos_] == '-' || text_[pos_] == '+' || text_[pos_] == '.'))
+            {
+                ++pos_;
+            }
+            const std::string token = text_.substr(start, pos_ - start);
+            if (token != "true" && token != "false")
+            {
+                char *end = nullptr;
+                std::strtod(token.c_str(), &end);
+                if (token.empty() || end != token.c_str() + token.size())
+                {
+                    return false;
+                }
+            }
+            values[key] = token;
+            return true;
+        }
+
+        std::string text_;
+        size_t pos_ = 0;
+    };
+
+    uint64_t output_bytes(const std::string &dir, const std::string &stats_file)
+    {
+        uint64_t bytes = 0;
+        for (const auto &entry : std::filesystem::directory_iterator(dir))
+        {
+            if (entry.path().filename() != stats_file)
+            {
+                bytes += std::filesystem::file_size(entry.path());
+            }
+        }
+        return bytes;
+    }
+}
+
+int main()
+{
+    const std::string dir = scratch_dir("stats");
+
+    // 2 x 2 source locations one degree apart, two years: 8 rows
+    const std::string source_file = dir + "source.txt";
+    write_file(source_file, grid_by_time(80.0, 40.0, 1.0, 2, 2, 2000, 2, 1));
+
+    // Three target locations, two years: 6 rows. Within 80 km the cell centre has
+    // all 4 sources, (80.0, 40.1) has 1 and (90, 45) has none, so with
+    // min_points = 2 the last two fall back to their nearest source.
+    const std::string target_file = dir + "target.txt";
+    std::string target_text = "Lon Lat Year M1 M2 M3 M4 M5 M6 M7 M8 M9 M10 M11 M12\n";
+    for (const char *location : {"80.5 40.5", "80.0 40.1", "90.0 45.0"})
+    {
+        for (const char *year : {"2000", "2001"})
+        {
+            target_text += std::string(location) + ' ' + year + " 0 0 0 0 0 0 0 0 0 0 0 0\n";
+        }
+    }
+    write_file(target_file, target_text);
+    const uint64_t input_bytes = read_file(source_file).size() + target_text.size();
+
+    struct Case
+    {
+        InterpolationMethod method;
+        bool write_mappings;
+        uint64_t distance_evaluations; // 3 targets x 4 sources per search, plus 4 per fallback
+        uint64_t fallbacks;
+    };
+    for (const Case &test : {Case{NEAREST_NEIGHBOR, false, 12, 0}, Case{INVERSE_DISTANCE_WEIGHTED, false, 12 + 8, 2},
+                             Case{INVERSE_DISTANCE_WEIGHTED, true, 12 + 12 + 8, 2}})
+    {
+        RegridConfig config;
+        config.output_path = dir + (test.method == NEAREST_NEIGHBOR ? "nn" : "idw") +
+                             (test.write_mappings ? "_mappings/" : "/");
+        config.interp_method = test.method;
+        config.radius = 80.0;
+        config.min_points = 2;
+        config.max_points = 4;
+        config.write_mappings = test.write_mappings;
+        config.write_stats = true;
+        config.num_threads = 2;
+        const RegridStats stats = Regridder(source_file, target_file, config).regrid();
+
+        CHECK(stats.rows_read == 8 + 6);
+        CHECK(stats.rows_written == 6);
+        CHECK(stats.bytes_read == input_bytes);
+        CHECK(stats.bytes_written == output_bytes(config.output_path, config.stats_file));
+        CHECK(stats.distance_evaluations == test.distance_evaluations);
+        CHECK(stats.fallbacks == test.fallbacks);
+        CHECK(stats.total.wall_seconds > 0.0);
+        CHECK(stats.search.wall_seconds >= 0.0 && stats.search.cpu_seconds >= 0.0);
+
+        const std::string text = read_file(config.output_path + config.stats_file);
+        const FlatJson json(text);
+        CHECK(json.ok);
+        CHECK(text == stats.to_json());
+        for (const char *stage : {"read_source", "parse", "search", "interpolate", "format", "write", "total"})
+        {
+            CHECK(json.values.count(std::string("stages.") + stage + ".wall_seconds") == 1);
+            CHECK(json.values.count(std::string("stages.") + stage + ".cpu_seconds") == 1);
+        }
+        const std::map<std::string, uint64_t> counts = {{"rows_read", stats.rows_read},
+                                                        {"rows_written", stats.rows_written},
+                                                        {"bytes_read", stats.bytes_read},
+                                                        {"bytes_written", stats.bytes_written},
+                                                        {"distance_evaluations", stats.distance_evaluations},
+                                                        {"fallbacks", stats.fallbacks}};
+        for (const auto &[key, count] : counts)
+        {
+            CHECK(json.values.count(key) == 1 && json.values.at(key) == std::to_string(count));
+        }
+    }
+
+    // Text that is not JSON is rejected by the reader above
+    CHECK(!FlatJson("{\"rows_read\": 1,}").ok);
+    CHECK(!FlatJson("{\"rows_read\": 1").ok);
+
+    return result("test_stats");
+}
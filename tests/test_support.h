@@ -0,0 +1,162 @@
+/*
+ * test_support.h
+ * Checks, sample grids and file helpers shared by the FastRegrid tests.
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#ifndef FASTREGRID_TEST_SUPPORT_H
+#define FASTREGRID_TEST_SUPPORT_H
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fastregrid_test
+{
+
+    inline int &failures()
+    {
+        static int count = 0;
+        return count;
+    }
+
+// Records a failed condition and carries on with the test.
+#define CHECK(condition)                                                                           \
+    do                                                                                             \
+    {                                                                                              \
+        if (!(condition))                                                                          \
+        {                                                                                          \
+            std::cerr << __FILE__ << ':' << __LINE__ << ": CHECK failed: " #condition << std::endl; \
+            ++fastregrid_test::failures();                                                         \
+        }                                                                                          \
+    } while (false)
+
+    // Exit code of a test: 0 if every check passed.
+    inline int result(const char *name)
+    {
+        if (failures() != 0)
+        {
+            std::cerr << name << ": " << failures() << " check(s) failed" << std::endl;
+            return 1;
+        }
+        std::cout << name << ": passed" << std::endl;
+        return 0;
+    }
+
+    // Empty scratch directory for one test, with a trailing separator.
+    inline std::string scratch_dir(const std::string &name)
+    {
+        const std::filesystem::path dir = std::filesystem::temp_directory_path() / "fastregrid_tests" / name;
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+        return dir.string() + "/";
+    }
+
+    inline std::string read_file(const std::string &filename)
+    {
+        std::ifstream file(filename, std::ios::binary);
+        std::ostringstream text;
+        text << file.rdbuf();
+        return text.str();
+    }
+
+    inline void write_file(const std::string &filename, const std::string &text)
+    {
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        file << text;
+    }
+
+    // Regular grid of lon_count x lat_count points from (lon0, lat0) in steps of
+    // step degrees, as GRID_BY_TIME text with one row per point and year and 12
+    // pseudo-random monthly values (the same for the same seed).
+    inline std::string grid_by_time(double lon0, double lat0, double step, int lon_count, int lat_count,
+                                    int first_year, int years, uint32_t seed)
+    {
+        std::ostringstream text;
+        text << "Lon Lat Year M1 M2 M3 M4 M5 M6 M7 M8 M9 M10 M11 M12\n";
+        uint32_t state = seed;
+        char value[32];
+        for (int i = 0; i < lon_count; ++i)
+        {
+            for (int j = 0; j < lat_count; ++j)
+            {
+                for (int year = first_year; year < first_year + years; ++year)
+                {
+                    std::snprintf(value, sizeof(value), "%.4f %.4f", lon0 + step * i, lat0 + step * j);
+                    text << value << ' ' << year;
+                    for (int month = 0; month < 12; ++month)
+                    {
+                        state = state * 1664525u + 1013904223u;
+                        std::snprintf(value, sizeof(value), " %.4f", (state >> 8) * (10.0 / 16777216.0));
+                        text << value;
+                    }
+                    text << '\n';
+                }
+            }
+        }
+        return text.str();
+    }
+
+    // Source and target of the tests: a 12 x 10 source grid at 0.5 degree and a
+    // 15 x 12 target grid at 0.37 degree over the same area, three years each.
+    inline void write_sample_grids(const std::string &dir, std::string &source_file, std::string &target_file)
+    {
+        source_file = dir + "source.txt";
+        target_file = dir + "target.txt";
+        write_file(source_file, grid_by_time(80.0, 40.0, 0.5, 12, 10, 2000, 3, 1));
+        write_file(target_file, grid_by_time(80.1, 39.9, 0.37, 15, 12, 2000, 3, 2));
+    }
+
+    // Locations of a GRID_BY_TIME file whose rows run year-fastest (as written
+    // by grid_by_time) and, per location, the 12 monthly values of its years
+    // one after another.
+    template <typename Value>
+    void read_grid_by_location(const std::string &filename, size_t years, std::vector<double> &lons,
+                               std::vector<double> &lats, std::vector<Value> &values)
+    {
+        std::istringstream in(read_file(filename));
+        std::string line;
+        std::getline(in, line); // Header
+        for (size_t row = 0; std::getline(in, line); ++row)
+        {
+            std::istringstream fields(line);
+            double lon = 0, lat = 0, value = 0;
+            int year = 0;
+            fields >> lon >> lat >> year;
+            if (row % years == 0)
+            {
+                lons.push_back(lon);
+                lats.push_back(lat);
+            }
+            for (int month = 0; month < 12 && fields >> value; ++month)
+            {
+                values.push_back(static_cast<Value>(value));
+            }
+        }
+    }
+
+    // Lines of text, without line ends.
+    inline std::vector<std::string> lines_of(const std::string &text)
+    {
+        std::vector<std::string> lines;
+        std::istringstream in(text);
+        for (std::string line; std::getline(in, line);)
+        {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+} // namespace fastregrid_test
+
+#endif // FASTREGRID_TEST_SUPPORT_H
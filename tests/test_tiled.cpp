@@ -0,0 +1,75 @@
+// A tiled run writes the rows of an untiled run, grouped by tile: targets with
+// no source within radius, even far from all sources, still get their
+// nearest source (Nearest Neighbor and the IDW fallback), whatever the tile
+// size.
+
+#include "test_support.h"
+#include "../include/fastregrid/regridder.h"
+#include <algorithm>
+
+using namespace fastregrid;
+using namespace fastregrid_test;
+
+namespace
+{
+    std::vector<std::string> sorted_lines(const std::string &filename)
+    {
+        std::vector<std::string> lines = lines_of(read_file(filename));
+        std::sort(lines.begin(), lines.end());
+        return lines;
+    }
+}
+
+int main()
+{
+    const std::string dir = scratch_dir("tiled");
+    std::string source_file, target_file;
+    write_sample_grids(dir, source_file, target_file);
+
+    // The sample target plus points beyond the radius of every source: next to
+    // the source area, a few degrees away and on the other side of the globe
+    const std::string far_file = dir + "target_far.txt";
+    std::string far_text = read_file(target_file);
+    for (const std::string &extra : {grid_by_time(86.3, 39.0, 1.7, 3, 3, 2000, 3, 5),
+                                     grid_by_time(95.0, 30.0, 4.0, 2, 2, 2000, 3, 6),
+                                     grid_by_time(-100.0, -45.0, 0.5, 2, 1, 2000, 3, 7)})
+    {
+        far_text += extra.substr(extra.find('\n') + 1);
+    }
+    write_file(far_file, far_text);
+
+    size_t runs = 0;
+    for (InterpolationMethod method : {NEAREST_NEIGHBOR, INVERSE_DISTANCE_WEIGHTED})
+    {
+        for (DistanceMetric metric : {HAVERSINE, EUCLIDEAN})
+        {
+            for (double radius : {20.0, 80.0})
+            {
+                RegridConfig config;
+                config.interp_method = method;
+                config.distance_metric = metric;
+                config.radius = radius;
+                config.min_points = 2;
+                config.max_points = 4;
+                config.write_mappings = false;
+                config.num_threads = 2;
+                config.output_path = dir + "untiled_" + std::to_string(runs) + "/";
+                Regridder(source_file, far_file, config).regrid();
+                const std::vector<std::string> untiled = sorted_lines(config.output_path + "regridded.txt");
+                CHECK(untiled.size() == lines_of(far_text).size());
+
+                for (double tile_size : {0.5, 2.0, 30.0})
+                {
+                    config.tile_size = tile_size;
+                    config.output_path = dir + "tiled_" + std::to_string(runs) + "_" + std::to_string(tile_size) + "/";
+                    const RegridStats stats = Regridder(source_file, far_file, config).regrid();
+                    CHECK(sorted_lines(config.output_path + "regridded.txt") == untiled);
+                    CHECK(stats.rows_written + 1 == untiled.size());
+                }
+                ++runs;
+            }
+        }
+    }
+
+    return result("test_tiled");
+}
@@ -0,0 +1,105 @@
+/*
+ * cli_options.h
+ * Regridding options shared by the FastRegrid command-line tools.
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#ifndef FASTREGRID_TOOLS_CLI_OPTIONS_H
+#define FASTREGRID_TOOLS_CLI_OPTIONS_H
+
+#include "config.h"
+#include <string>
+#include <stdexcept>
+
+namespace fastregrid
+{
+    namespace cli
+    {
+
+        // Usage lines of the options understood by apply_config_option().
+        inline const char *config_options_usage()
+        {
+            return "  --method nn|idw                   Interpolation method (default idw)\n"
+                   "  --layout grid_by_time|year_by_year Data layout (default grid_by_time)\n"
+                   "  --metric haversine|euclidean      Distance metric (default haversine)\n"
+                   "  --radius <km>                     IDW search radius (default 100)\n"
+                   "  --power <p>                       IDW power (default 2)\n"
+                   "  --min-points <n>                  IDW minimum points (default 5)\n"
+                   "  --max-points <n>                  IDW maximum points (default 5)\n"
+                   "  --precision <n>                   Output decimal places (default 5)\n"
+                   "  --threads <n>                     Compute threads, 0 = all (default 0)\n"
+                   "  --memory-budget <bytes>           Source value budget (default unlimited)\n";
+        }
+
+        // Applies one "--option value" pair to builder. Returns false if the
+        // option is not a regridding option; throws on invalid values.
+        inline bool apply_config_option(const std::string &option, const std::string &value, RegridConfigBuilder &builder)
+        {
+            if (option == "--method")
+            {
+                if (value != "nn" && value != "idw")
+                {
+                    throw std::invalid_argument("Unknown method: " + value);
+                }
+                builder.set_interpolation(value == "nn" ? NEAREST_NEIGHBOR : INVERSE_DISTANCE_WEIGHTED);
+            }
+            else if (option == "--layout")
+            {
+                if (value != "grid_by_time" && value != "year_by_year")
+                {
+                    throw std::invalid_argument("Unknown layout: " + value);
+                }
+                builder.set_data_layout(value == "grid_by_time" ? GRID_BY_TIME : YEAR_BY_YEAR);
+            }
+            else if (option == "--metric")
+            {
+                if (value != "haversine" && value != "euclidean")
+                {
+                    throw std::invalid_argument("Unknown metric: " + value);
+                }
+                builder.set_distance_metric(value == "haversine" ? HAVERSINE : EUCLIDEAN);
+            }
+            else if (option == "--radius")
+            {
+                builder.set_radius(std::stod(value));
+            }
+            else if (option == "--power")
+            {
+                builder.set_power(std::stod(value));
+            }
+            else if (option == "--min-points")
+            {
+                builder.set_min_points(std::stoi(value));
+            }
+            else if (option == "--max-points")
+            {
+                builder.set_max_points(std::stoi(value));
+            }
+            else if (option == "--precision")
+            {
+                builder.set_precision(std::stoi(value));
+            }
+            else if (option == "--threads")
+            {
+                builder.set_num_threads(std::stoul(value));
+            }
+            else if (option == "--memory-budget")
+            {
+                builder.set_memory_budget(std::stoull(value));
+            }
+            else
+            {
+                return false;
+            }
+            return true;
+        }
+
+    } // namespace cli
+} // namespace fastregrid
+
+#endif // FASTREGRID_TOOLS_CLI_OPTIONS_H
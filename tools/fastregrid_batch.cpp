@@ -0,0 +1,89 @@
+/*
+ * fastregrid_batch.cpp
+ * Command-line runner for manifests of regridding jobs (see batch.h).
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#include "batch.h"
+#include "cli_options.h"
+#include <iostream>
+#include <string>
+#include <stdexcept>
+
+using namespace fastregrid;
+
+namespace
+{
+
+    void print_usage(const char *program)
+    {
+        std::cerr << "Usage: " << program << " <manifest> [options]\n"
+                  << "Manifest lines: <source> <target> <output_dir> ('#' starts a comment)\n"
+                  << "Options:\n"
+                  << cli::config_options_usage()
+                  << "  --io <n>                          Jobs reading or writing at once (default 2)\n"
+                  << "  --verbose                         Print progress\n";
+    }
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    RegridConfigBuilder builder;
+    builder.set_num_threads(0);
+    size_t max_io = 2;
+    try
+    {
+        for (int i = 2; i < argc; ++i)
+        {
+            const std::string option = argv[i];
+            if (option == "--verbose")
+            {
+                builder.set_verbose(true);
+                continue;
+            }
+            if (i + 1 >= argc)
+            {
+                throw std::invalid_argument("Missing value for " + option);
+            }
+            const std::string value = argv[++i];
+            if (option == "--io")
+            {
+                max_io = std::stoul(value);
+            }
+            else if (!cli::apply_config_option(option, value, builder))
+            {
+                throw std::invalid_argument("Unknown option: " + option);
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    try
+    {
+        RegridConfig config = builder.build();
+        BatchRunner runner(read_manifest(argv[1]), config, max_io);
+        return runner.run() == 0 ? 0 : 1;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 2;
+    }
+}
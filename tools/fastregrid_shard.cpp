@@ -0,0 +1,202 @@
+/*
+ * fastregrid_shard.cpp
+ * Command-line driver for multi-process sharded regridding (see shard.h).
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#include "shard.h"
+#include "cli_options.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace fastregrid;
+
+namespace
+{
+
+    void print_usage(const char *program)
+    {
+        std::cerr << "Usage: " << program << " prepare <source> <target> <output_dir> [options]\n"
+                  << "       " << program << " run     <source> <target> <output_dir> --shard <k> --shards <n> [options]\n"
+                  << "       " << program << " merge   <source> <target> <output_dir> --shards <n> [options]\n"
+                  << "       " << program << " launch  <source> <target> <output_dir> --shards <n> [options]\n"
+                  << "launch runs prepare, then one local worker process per shard, then merge.\n"
+                  << "Options:\n"
+                  << cli::config_options_usage()
+                  << "  --shard <k>                       Shard to run, from 0\n"
+                  << "  --shards <n>                      Number of shards\n"
+                  << "  --verbose                         Print progress\n";
+    }
+
+    // Starts "program run ... --shard k" in a new process; returns its pid.
+    pid_t spawn_worker(const char *program, const std::vector<std::string> &args)
+    {
+        std::vector<char *> argv;
+        argv.push_back(const_cast<char *>(program));
+        for (const auto &arg : args)
+        {
+            argv.push_back(const_cast<char *>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+        pid_t pid = fork();
+        if (pid < 0)
+        {
+            throw std::runtime_error("Cannot start worker process");
+        }
+        if (pid == 0)
+        {
+            // The parent may have threads running: only exec is safe here
+            execvp(program, argv.data());
+            _exit(127);
+        }
+        return pid;
+    }
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 5)
+    {
+        print_usage(argv[0]);
+        return 2;
+    }
+    const std::string command = argv[1];
+    const std::string source_file = argv[2];
+    const std::string target_file = argv[3];
+
+    RegridConfigBuilder builder;
+    builder.set_num_threads(0);
+    builder.set_output_path(argv[4]);
+    size_t shard = 0;
+    size_t num_shards = 0;
+    bool has_shard = false;
+    bool has_threads = false;
+    std::vector<std::string> forwarded; // Options passed on to launched workers
+    try
+    {
+        if (command != "prepare" && command != "run" && command != "merge" && command != "launch")
+        {
+            throw std::invalid_argument("Unknown command: " + command);
+        }
+        for (int i = 5; i < argc; ++i)
+        {
+            const std::string option = argv[i];
+            if (option == "--verbose")
+            {
+                builder.set_verbose(true);
+                forwarded.push_back(option);
+                continue;
+            }
+            if (i + 1 >= argc)
+            {
+                throw std::invalid_argument("Missing value for " + option);
+            }
+            const std::string value = argv[++i];
+            if (option == "--shard")
+            {
+                shard = std::stoul(value);
+                has_shard = true;
+            }
+            else if (option == "--shards")
+            {
+                num_shards = std::stoul(value);
+            }
+            else if (cli::apply_config_option(option, value, builder))
+            {
+                has_threads = has_threads || option == "--threads";
+                forwarded.push_back(option);
+                forwarded.push_back(value);
+            }
+            else
+            {
+                throw std::invalid_argument("Unknown option: " + option);
+            }
+        }
+        if (command != "prepare" && num_shards == 0)
+        {
+            throw std::invalid_argument("--shards is required for " + command);
+        }
+        if (command == "run" && !has_shard)
+        {
+            throw std::invalid_argument("--shard is required for run");
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    try
+    {
+        RegridConfig config = builder.build();
+        ShardedRegrid regrid(source_file, target_file, config);
+        if (command == "prepare")
+        {
+            regrid.prepare();
+            return 0;
+        }
+        if (command == "run")
+        {
+            regrid.run(shard, num_shards);
+            return 0;
+        }
+        if (command == "merge")
+        {
+            regrid.merge(num_shards);
+            return 0;
+        }
+
+        // launch: split the hardware threads between workers unless --threads was given
+        regrid.prepare();
+        if (!has_threads)
+        {
+            const size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+            forwarded.push_back("--threads");
+            forwarded.push_back(std::to_string(std::max<size_t>(1, hardware / num_shards)));
+        }
+        std::vector<pid_t> workers;
+        for (size_t k = 0; k < num_shards; ++k)
+        {
+            std::vector<std::string> args = {"run", source_file, target_file, argv[4], "--shard", std::to_string(k),
+                                             "--shards", std::to_string(num_shards)};
+            args.insert(args.end(), forwarded.begin(), forwarded.end());
+            workers.push_back(spawn_worker(argv[0], args));
+        }
+        size_t failed = 0;
+        for (size_t k = 0; k < workers.size(); ++k)
+        {
+            int status = 0;
+            if (waitpid(workers[k], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            {
+                std::cerr << "Shard " << k << " failed" << std::endl;
+                ++failed;
+            }
+        }
+        if (failed != 0)
+        {
+            return 1;
+        }
+        regrid.merge(num_shards);
+        return 0;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 2;
+    }
+}
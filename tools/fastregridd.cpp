@@ -0,0 +1,135 @@
+/*
+ * fastregridd.cpp
+ * Resident regridding daemon over a Unix domain socket (see daemon.h), with a minimal client mode.
+ *
+ * Author: Kevin Takyi Yeboah
+ * Created: June, 2025
+ *
+ * Copyright (c) 2025 Kevin Takyi Yeboah
+ * License: [MIT License, see LICENSE file]
+ */
+
+#include "daemon.h"
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <stdexcept>
+
+using namespace fastregrid;
+
+namespace
+{
+
+    RegridDaemon *running_daemon = nullptr;
+
+    void handle_signal(int)
+    {
+        if (running_daemon)
+        {
+            running_daemon->stop(); // Only stores an atomic flag
+        }
+    }
+
+    void print_usage(const char *program)
+    {
+        std::cerr << "Usage: " << program << " --socket <path> [options]\n"
+                  << "       " << program << " --socket <path> --send <command> [key=value ...]\n"
+                  << "Options:\n"
+                  << "  --cache-bytes <n>  LRU cache budget for targets and weights (default 1 GiB)\n"
+                  << "  --clients <n>      Connections served at once (default 16)\n"
+                  << "  --threads <n>      Compute threads, 0 = all (default 0)\n"
+                  << "  --verbose          Print progress\n"
+                  << "Commands: REGRID (source=, target=, output= or shm=, method=, metric=, layout=,\n"
+                  << "          radius=, power=, min_points=, max_points=, precision=), PING, STATS, SHUTDOWN\n";
+    }
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string socket_path;
+    size_t cache_bytes = size_t(1) << 30;
+    size_t max_clients = 16;
+    RegridConfigBuilder builder;
+    builder.set_num_threads(0);
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string option = argv[i];
+            if (option == "--verbose")
+            {
+                builder.set_verbose(true);
+                continue;
+            }
+            if (i + 1 >= argc)
+            {
+                throw std::invalid_argument("Missing value for " + option);
+            }
+            if (option == "--send")
+            {
+                // Client mode: the remaining arguments form the request, one per line
+                std::string payload;
+                for (++i; i < argc; ++i)
+                {
+                    payload += std::string(argv[i]) + '\n';
+                }
+                if (socket_path.empty())
+                {
+                    throw std::invalid_argument("--socket must come before --send");
+                }
+                const std::string response = protocol::request(socket_path, payload);
+                std::cout << response;
+                return response.compare(0, 3, "OK\n") == 0 ? 0 : 1;
+            }
+            const std::string value = argv[++i];
+            if (option == "--socket")
+            {
+                socket_path = value;
+            }
+            else if (option == "--cache-bytes")
+            {
+                cache_bytes = std::stoull(value);
+            }
+            else if (option == "--clients")
+            {
+                max_clients = std::stoul(value);
+            }
+            else if (option == "--threads")
+            {
+                builder.set_num_threads(std::stoul(value));
+            }
+            else
+            {
+                throw std::invalid_argument("Unknown option: " + option);
+            }
+        }
+        if (socket_path.empty())
+        {
+            throw std::invalid_argument("Missing --socket");
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    try
+    {
+        RegridDaemon daemon(socket_path, builder.build(), cache_bytes, max_clients);
+        running_daemon = &daemon;
+        std::signal(SIGINT, handle_signal);
+        std::signal(SIGTERM, handle_signal);
+        std::signal(SIGPIPE, SIG_IGN);
+        daemon.serve();
+        running_daemon = nullptr;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}